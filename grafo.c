@@ -1,6 +1,14 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Tipos de dispositivo
 typedef enum {
@@ -22,6 +30,7 @@ typedef enum {
 typedef struct Aresta {
     int destino;
     TipoConexao tipo;
+    int capacidade; // Capacidade do enlace em Mbps
     struct Aresta* proxima;
 } Aresta;
 
@@ -38,8 +47,124 @@ typedef struct {
     Vertice* vertices;
     int num_vertices;
     int capacidade;
+    // Tradução de IDs externos, criada na primeira reordenação (antes dela, ID externo =
+    // índice). Um dispositivo novo recebe o próximo ID externo
+    int* id_externo;       // índice -> ID externo
+    int* indice_externo;   // ID externo -> índice atual (-1 = removido)
+    int num_externos;
+    int capacidade_externos;
 } Grafo;
 
+// Fluxo de tráfego entre dois dispositivos (entrada da simulação)
+typedef struct {
+    int origem;
+    int destino;
+    double taxa;     // Mbps
+    double inicio;   // segundos
+    double duracao;  // segundos
+} FluxoTrafego;
+
+// Resumo de uma simulação de tráfego
+typedef struct {
+    long long eventos_processados;
+    int fluxos_roteados;
+    int fluxos_sem_rota;
+    double tempo_simulado;      // segundos
+    double latencia_media_ms;   // latência média dos fluxos no momento em que iniciam
+    double latencia_maxima_ms;
+} ResultadoSimulacao;
+
+// Uso de um enlace (um sentido de uma conexão) ao longo da simulação
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+    int capacidade;
+    double utilizacao_media;    // fração da capacidade (média no tempo)
+    double utilizacao_pico;
+    double atraso_fila_medio_ms;
+    double tempo_saturado;      // segundos com carga >= capacidade
+} UsoEnlace;
+
+// Grafo mapeado em arquivo (somente leitura). O arquivo contém um cabeçalho, a tabela
+// de vértices e o vetor de arcos (CSR); as páginas são carregadas sob demanda pelo SO.
+typedef struct {
+    char assinatura[8];        // "REDEMAP"
+    int versao;
+    int num_vertices;
+    long long num_arcos;
+    long long inicio_vertices; // deslocamento (bytes) da tabela de vértices
+    long long inicio_arcos;    // deslocamento (bytes) do vetor de arcos
+} CabecalhoMapeado;
+
+typedef struct {
+    int tipo;
+    int grau;
+    long long primeiro_arco;
+    char nome[50];
+} VerticeMapeado;
+
+typedef struct {
+    int destino;
+    int tipo;
+    int capacidade;
+} ArcoMapeado;
+
+typedef struct {
+    int descritor;
+    void* base;
+    size_t tamanho;
+    int num_vertices;
+    long long num_arcos;
+    const VerticeMapeado* vertices;
+    const ArcoMapeado* arcos;
+} GrafoMapeado;
+
+// Critério de reordenação dos vértices (melhora a localidade das listas de adjacência)
+typedef enum {
+    REORDENAR_RCM,        // Reverse Cuthill-McKee
+    REORDENAR_HIERARQUIA  // Switch, depois seus servidores, access points e computadores
+} CriterioReordenacao;
+
+// Conexão de uma árvore de distribuição (árvore geradora ou de Steiner)
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+} ArestaArvore;
+
+// Histórico de versões da topologia (definido na seção do histórico)
+typedef struct HistoricoGrafo HistoricoGrafo;
+
+// Resultado da análise de diâmetro
+typedef struct {
+    int diametro;   // maior menor-distância entre dois dispositivos conectados
+    int origem;     // par de dispositivos que realiza o diâmetro
+    int destino;
+    int buscas;     // buscas completas executadas (uma por dispositivo sem os limitantes)
+} ResultadoDiametro;
+
+// Dispositivo e conexão para carga em lote (carregar_em_lote)
+typedef struct {
+    TipoDispositivo tipo;
+    char nome[50];
+} DispositivoLote;
+
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+} ConexaoLote;
+
+// Restrições de uma consulta de rota (encontrar_rota_restrita)
+typedef struct {
+    unsigned int conexoes;      // bit (1 << TipoConexao) de cada conexão permitida; 0 = todas
+    unsigned int dispositivos;  // bit (1 << TipoDispositivo) de cada tipo permitido no meio da rota; 0 = todos
+    int max_saltos;             // número máximo de conexões na rota; <= 0 = sem limite
+    const int* excluidos;       // dispositivos que não podem aparecer na rota
+    int num_excluidos;
+} RestricaoRota;
+
 // Declarações das funções
 Grafo* criar_grafo(int capacidade);
 void destruir_grafo(Grafo* g);
@@ -54,6 +179,52 @@ const char* tipo_conexao_str(TipoConexao tipo);
 int obter_peso_conexao(TipoConexao tipo);
 int dfs_rota_mais_rapida(Grafo* g, int atual, int destino, int* visitado, int* caminho_atual, int* melhor_caminho, int profundidade, int peso_atual, int* melhor_peso, int max_profundidade);
 int encontrar_rota_mais_rapida(Grafo* g, int origem, int destino, int* caminho, int* tamanho_caminho);
+int obter_capacidade_conexao(TipoConexao tipo);
+int definir_capacidade_aresta(Grafo* g, int origem, int destino, int capacidade);
+int contar_arestas(Grafo* g);
+long long calcular_fluxo_maximo(Grafo* g, const int* origens, int num_origens, const int* destinos, int num_destinos, int* corte, int* tamanho_corte);
+int calcular_distancias(Grafo* g, int origem, int* distancia, int* anterior);
+int encontrar_rota_dial(Grafo* g, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+int simular_trafego(Grafo* g, const FluxoTrafego* fluxos, int num_fluxos, ResultadoSimulacao* resultado, UsoEnlace* enlaces);
+int calcular_centralidade(Grafo* g, double* centralidade, int amostras, int num_threads);
+int ranquear_centralidade(Grafo* g, const double* centralidade, TipoDispositivo tipo, int* ids, int max_ids);
+int exportar_grafo_mapeado(Grafo* g, const char* caminho);
+GrafoMapeado* abrir_grafo_mapeado(const char* caminho);
+void fechar_grafo_mapeado(GrafoMapeado* gm);
+void preparar_varredura_mapeado(GrafoMapeado* gm);
+Grafo* importar_grafo_mapeado(GrafoMapeado* gm, int folga);
+int encontrar_rota_mapeado(GrafoMapeado* gm, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+int calcular_distancias_mapeado(GrafoMapeado* gm, int origem, int* distancia);
+void gerar_mermaid_mapeado(GrafoMapeado* gm, FILE* arquivo);
+int reordenar_vertices(Grafo* g, CriterioReordenacao criterio, int* novo_id);
+int renumerar_vertices(Grafo* g, int* novo_id);
+int obter_id_externo(Grafo* g, int indice);
+int resolver_id_externo(Grafo* g, int externo);
+int calcular_arvore_geradora(Grafo* g, ArestaArvore* arestas, int* num_arestas, int* peso_total);
+int calcular_arvore_distribuicao(Grafo* g, const int* terminais, int num_terminais, ArestaArvore* arestas, int* num_arestas, int* peso_total);
+void gerar_mermaid_arvore(Grafo* g, const ArestaArvore* arestas, int num_arestas, FILE* arquivo);
+HistoricoGrafo* criar_historico(Grafo* g, long long instante);
+void destruir_historico(HistoricoGrafo* h);
+int historico_registrar_grafo(HistoricoGrafo* h, long long instante, Grafo* g, const char* descricao);
+int historico_adicionar_vertice(HistoricoGrafo* h, long long instante, TipoDispositivo tipo, const char* nome);
+int historico_adicionar_aresta(HistoricoGrafo* h, long long instante, int origem, int destino, TipoConexao tipo);
+int historico_remover_aresta(HistoricoGrafo* h, long long instante, int origem, int destino);
+int historico_definir_capacidade(HistoricoGrafo* h, long long instante, int origem, int destino, int capacidade);
+int historico_remover_vertice(HistoricoGrafo* h, long long instante, int id);
+int historico_adicionar_lote(HistoricoGrafo* h, long long instante, const DispositivoLote* dispositivos, int num_dispositivos, const ConexaoLote* conexoes, int num_conexoes);
+int historico_num_versoes(HistoricoGrafo* h);
+int historico_versao_em(HistoricoGrafo* h, long long instante);
+int historico_info_versao(HistoricoGrafo* h, int versao, long long* instante, int* num_vertices, const char** descricao);
+const char* historico_nome_dispositivo(HistoricoGrafo* h, int versao, int id);
+size_t historico_memoria(HistoricoGrafo* h);
+int encontrar_rota_versao(HistoricoGrafo* h, int versao, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void gerar_mermaid_versao(HistoricoGrafo* h, int versao, FILE* arquivo);
+int calcular_diametro(Grafo* g, int por_saltos, ResultadoDiametro* resultado);
+int calcular_excentricidades(Grafo* g, int por_saltos, int* excentricidade, ResultadoDiametro* resultado);
+int carregar_em_lote(Grafo* g, const DispositivoLote* dispositivos, int num_dispositivos, const ConexaoLote* conexoes, int num_conexoes, int num_threads, int* rejeitadas);
+int particionar_grafo(Grafo* g, int max_particoes, int* particao);
+int exportar_particao_mapeada(Grafo* g, const int* particao, const int* id_local, const int* membros, int num_membros, const char* caminho);
+int encontrar_rota_restrita(Grafo* g, int origem, int destino, const RestricaoRota* restricao, int* caminho, int* tamanho_caminho, int* peso);
 
 // Cria um novo grafo
 Grafo* criar_grafo(int capacidade) {
@@ -68,6 +239,10 @@ Grafo* criar_grafo(int capacidade) {
 
     g->num_vertices = 0;
     g->capacidade = capacidade;
+    g->id_externo = NULL;
+    g->indice_externo = NULL;
+    g->num_externos = 0;
+    g->capacidade_externos = 0;
 
     for (int i = 0; i < capacidade; i++) {
         g->vertices[i].id = i;
@@ -91,14 +266,69 @@ void destruir_grafo(Grafo* g) {
     }
 
     free(g->vertices);
+    free(g->id_externo);
+    free(g->indice_externo);
     free(g);
 }
 
+// Garante espaço na tradução de IDs externos para mais 'quantidade' dispositivos.
+// Retorna 0 se faltar memória (a tradução não é alterada)
+static int reservar_ids_externos(Grafo* g, int quantidade) {
+    if (quantidade > INT_MAX - g->num_externos) return 0;
+
+    int necessario = g->num_externos + quantidade;
+    if (necessario <= g->capacidade_externos) return 1;
+
+    int capacidade = g->capacidade_externos > 0 ? g->capacidade_externos : 16;
+    while (capacidade < necessario) {
+        capacidade = capacidade > INT_MAX / 2 ? necessario : capacidade * 2;
+    }
+
+    int* id_externo = (int*)realloc(g->id_externo, (size_t)capacidade * sizeof(int));
+    if (!id_externo) return 0;
+    g->id_externo = id_externo;
+
+    int* indice_externo = (int*)realloc(g->indice_externo, (size_t)capacidade * sizeof(int));
+    if (!indice_externo) return 0;
+    g->indice_externo = indice_externo;
+
+    g->capacidade_externos = capacidade;
+    return 1;
+}
+
+// Cria a tradução de IDs externos (identidade) se ela ainda não existe.
+// Retorna 0 se faltar memória
+static int criar_ids_externos(Grafo* g) {
+    if (g->indice_externo) return 1;
+    if (!reservar_ids_externos(g, g->num_vertices > 0 ? g->num_vertices : 1)) return 0;
+
+    for (int i = 0; i < g->num_vertices; i++) {
+        g->id_externo[i] = i;
+        g->indice_externo[i] = i;
+    }
+    g->num_externos = g->num_vertices;
+    return 1;
+}
+
+// Registra os dispositivos de índice 'inicio' em diante como novos IDs externos (o
+// espaço deve ter sido reservado)
+static void anexar_ids_externos(Grafo* g, int inicio) {
+    if (!g->indice_externo) return;
+
+    for (int i = inicio; i < g->num_vertices; i++) {
+        g->id_externo[i] = g->num_externos;
+        g->indice_externo[g->num_externos++] = i;
+    }
+}
+
 // Adiciona um vértice ao grafo
 int adicionar_vertice(Grafo* g, TipoDispositivo tipo, const char* nome) {
     if (!g || g->num_vertices >= g->capacidade) {
         return -1;
     }
+    if (g->indice_externo && !reservar_ids_externos(g, 1)) {
+        return -1;
+    }
 
     int id = g->num_vertices;
     g->vertices[id].id = id;
@@ -108,6 +338,7 @@ int adicionar_vertice(Grafo* g, TipoDispositivo tipo, const char* nome) {
     g->vertices[id].lista_adjacencia = NULL;
 
     g->num_vertices++;
+    anexar_ids_externos(g, id);
     return id;
 }
 
@@ -165,6 +396,7 @@ int adicionar_aresta(Grafo* g, int origem, int destino, TipoConexao tipo) {
 
     nova_aresta->destino = destino;
     nova_aresta->tipo = tipo;
+    nova_aresta->capacidade = obter_capacidade_conexao(tipo);
     nova_aresta->proxima = g->vertices[origem].lista_adjacencia;
     g->vertices[origem].lista_adjacencia = nova_aresta;
 
@@ -177,6 +409,7 @@ int adicionar_aresta(Grafo* g, int origem, int destino, TipoConexao tipo) {
 
     nova_aresta_reversa->destino = origem;
     nova_aresta_reversa->tipo = tipo;
+    nova_aresta_reversa->capacidade = obter_capacidade_conexao(tipo);
     nova_aresta_reversa->proxima = g->vertices[destino].lista_adjacencia;
     g->vertices[destino].lista_adjacencia = nova_aresta_reversa;
 
@@ -267,6 +500,15 @@ int remover_vertice(Grafo* g, int id) {
         atual = prox;
     }
 
+    // O ID externo do removido deixa de valer; os seguintes descem uma posição
+    if (g->indice_externo) {
+        g->indice_externo[g->id_externo[id]] = -1;
+        for (int i = id; i < g->num_vertices - 1; i++) {
+            g->id_externo[i] = g->id_externo[i + 1];
+            g->indice_externo[g->id_externo[i]] = i;
+        }
+    }
+
     // Move os vértices seguintes para preencher o espaço
     for (int i = id; i < g->num_vertices - 1; i++) {
         g->vertices[i] = g->vertices[i + 1];
@@ -322,6 +564,69 @@ int obter_peso_conexao(TipoConexao tipo) {
     }
 }
 
+// Retorna a capacidade padrão (em Mbps) de uma conexão baseada no tipo
+// Fibra: 10000, Cabo: 1000, WiFi: 300, Satélite: 100
+int obter_capacidade_conexao(TipoConexao tipo) {
+    switch (tipo) {
+        case FIBRA: return 10000;
+        case CABO: return 1000;
+        case WIFI: return 300;
+        case SATELITE: return 100;
+        default: return 0;
+    }
+}
+
+// Sobrescreve a capacidade de uma conexão existente (nos dois sentidos)
+// Retorna 1 se a conexão foi encontrada, 0 caso contrário
+int definir_capacidade_aresta(Grafo* g, int origem, int destino, int capacidade) {
+    if (!g || origem < 0 || destino < 0 ||
+        origem >= g->num_vertices || destino >= g->num_vertices ||
+        origem == destino || capacidade <= 0) {
+        return 0;
+    }
+
+    int encontrou = 0;
+
+    Aresta* atual = g->vertices[origem].lista_adjacencia;
+    while (atual) {
+        if (atual->destino == destino) {
+            atual->capacidade = capacidade;
+            encontrou = 1;
+            break;
+        }
+        atual = atual->proxima;
+    }
+
+    if (!encontrou) return 0;
+
+    atual = g->vertices[destino].lista_adjacencia;
+    while (atual) {
+        if (atual->destino == origem) {
+            atual->capacidade = capacidade;
+            break;
+        }
+        atual = atual->proxima;
+    }
+
+    return 1;
+}
+
+// Conta as conexões do grafo (cada conexão não orientada conta uma vez)
+int contar_arestas(Grafo* g) {
+    if (!g) return 0;
+
+    int total = 0;
+    for (int i = 0; i < g->num_vertices; i++) {
+        Aresta* atual = g->vertices[i].lista_adjacencia;
+        while (atual) {
+            total++;
+            atual = atual->proxima;
+        }
+    }
+
+    return total / 2;
+}
+
 // Função auxiliar DFS recursiva para encontrar a rota mais rápida
 // Retorna 1 se encontrou um caminho melhor, 0 caso contrário
 int dfs_rota_mais_rapida(Grafo* g, int atual, int destino, int* visitado,
@@ -457,25 +762,3964 @@ void gerar_mermaid(Grafo* g, FILE* arquivo) {
     }
 
     // Gera as arestas (apenas uma vez, já que é não orientado)
-    int* visitado = (int*)calloc(g->num_vertices * g->num_vertices, sizeof(int));
-    if (!visitado) return;
-
+    // adicionar_aresta não permite conexões repetidas, então basta imprimir i < j
     for (int i = 0; i < g->num_vertices; i++) {
         Aresta* atual = g->vertices[i].lista_adjacencia;
         while (atual) {
             int j = atual->destino;
             // Evita duplicar arestas (i-j e j-i são a mesma aresta)
             if (i < j) {
-                int idx = i * g->num_vertices + j;
-                if (!visitado[idx]) {
-                    fprintf(arquivo, "    %d -- %s --- %d\n",
-                            i, tipo_conexao_str(atual->tipo), j);
-                    visitado[idx] = 1;
-                }
+                fprintf(arquivo, "    %d -- %s --- %d\n",
+                        i, tipo_conexao_str(atual->tipo), j);
             }
             atual = atual->proxima;
         }
     }
+}
 
-    free(visitado);
+
+// ===== Fluxo máximo / corte mínimo (algoritmo de Dinic) =====
+
+#define FLUXO_INFINITO (1LL << 60)
+
+// Rede residual em formato compacto (CSR) construída a partir das listas de adjacência.
+// Os arcos do nó i ficam em [inicio[i], inicio[i + 1]).
+// Os nós extras num_vertices e num_vertices + 1 são a super-origem e o super-destino.
+typedef struct {
+    int num_nos;
+    int* inicio;
+    int* destino;
+    int* reverso;
+    long long* residual;
+} RedeResidual;
+
+static void liberar_rede_residual(RedeResidual* r) {
+    free(r->inicio);
+    free(r->destino);
+    free(r->reverso);
+    free(r->residual);
+}
+
+// Monta a rede residual: cada conexão não orientada vira um par de arcos
+// (u -> v e v -> u), um sendo o reverso do outro, ambos com a capacidade da conexão
+static int montar_rede_residual(Grafo* g, RedeResidual* r,
+                                const int* origens, int num_origens,
+                                const int* destinos, int num_destinos) {
+    int n = g->num_vertices;
+    int super_origem = n;
+    int super_destino = n + 1;
+
+    r->num_nos = n + 2;
+    r->inicio = (int*)calloc(r->num_nos + 1, sizeof(int));
+    int* posicao = (int*)malloc((r->num_nos + 1) * sizeof(int));
+    if (!r->inicio || !posicao) {
+        free(r->inicio);
+        free(posicao);
+        return 0;
+    }
+
+    // Conta os arcos de cada nó
+    for (int i = 0; i < n; i++) {
+        Aresta* atual = g->vertices[i].lista_adjacencia;
+        while (atual) {
+            r->inicio[i + 1]++;
+            atual = atual->proxima;
+        }
+    }
+    for (int i = 0; i < num_origens; i++) {
+        r->inicio[super_origem + 1]++;
+        r->inicio[origens[i] + 1]++;
+    }
+    for (int i = 0; i < num_destinos; i++) {
+        r->inicio[super_destino + 1]++;
+        r->inicio[destinos[i] + 1]++;
+    }
+    for (int i = 0; i < r->num_nos; i++) {
+        r->inicio[i + 1] += r->inicio[i];
+    }
+
+    int num_arcos = r->inicio[r->num_nos];
+    r->destino = (int*)malloc(num_arcos * sizeof(int));
+    r->reverso = (int*)malloc(num_arcos * sizeof(int));
+    r->residual = (long long*)malloc(num_arcos * sizeof(long long));
+    if (!r->destino || !r->reverso || !r->residual) {
+        liberar_rede_residual(r);
+        free(posicao);
+        return 0;
+    }
+
+    memcpy(posicao, r->inicio, (r->num_nos + 1) * sizeof(int));
+
+    // Conexões da rede (cada uma aparece nas duas listas, trata apenas u < v)
+    for (int u = 0; u < n; u++) {
+        Aresta* atual = g->vertices[u].lista_adjacencia;
+        while (atual) {
+            int v = atual->destino;
+            if (u < v) {
+                int a = posicao[u]++;
+                int b = posicao[v]++;
+                r->destino[a] = v;
+                r->destino[b] = u;
+                r->reverso[a] = b;
+                r->reverso[b] = a;
+                r->residual[a] = atual->capacidade;
+                r->residual[b] = atual->capacidade;
+            }
+            atual = atual->proxima;
+        }
+    }
+
+    // Super-origem -> origens e destinos -> super-destino (capacidade ilimitada)
+    for (int i = 0; i < num_origens; i++) {
+        int a = posicao[super_origem]++;
+        int b = posicao[origens[i]]++;
+        r->destino[a] = origens[i];
+        r->destino[b] = super_origem;
+        r->reverso[a] = b;
+        r->reverso[b] = a;
+        r->residual[a] = FLUXO_INFINITO;
+        r->residual[b] = 0;
+    }
+    for (int i = 0; i < num_destinos; i++) {
+        int a = posicao[destinos[i]]++;
+        int b = posicao[super_destino]++;
+        r->destino[a] = super_destino;
+        r->destino[b] = destinos[i];
+        r->reverso[a] = b;
+        r->reverso[b] = a;
+        r->residual[a] = FLUXO_INFINITO;
+        r->residual[b] = 0;
+    }
+
+    free(posicao);
+    return 1;
+}
+
+// BFS na rede residual a partir de 'origem', preenchendo o nível de cada nó (-1 = inalcançável)
+// Retorna 1 se 'destino' é alcançável (destino < 0 percorre tudo)
+static int bfs_niveis(RedeResidual* r, int origem, int destino, int* nivel, int* fila) {
+    for (int i = 0; i < r->num_nos; i++) {
+        nivel[i] = -1;
+    }
+
+    int inicio_fila = 0, fim_fila = 0;
+    nivel[origem] = 0;
+    fila[fim_fila++] = origem;
+
+    while (inicio_fila < fim_fila) {
+        int u = fila[inicio_fila++];
+        for (int a = r->inicio[u]; a < r->inicio[u + 1]; a++) {
+            int v = r->destino[a];
+            if (r->residual[a] > 0 && nivel[v] < 0) {
+                nivel[v] = nivel[u] + 1;
+                fila[fim_fila++] = v;
+            }
+        }
+    }
+
+    return destino >= 0 && nivel[destino] >= 0;
+}
+
+// Encontra um fluxo bloqueante no grafo de níveis (DFS iterativa com ponteiro de arco atual)
+static long long fluxo_bloqueante(RedeResidual* r, int origem, int destino,
+                                  int* nivel, int* iterador, int* pilha) {
+    long long total = 0;
+    int topo = 0;
+    int u = origem;
+
+    memcpy(iterador, r->inicio, r->num_nos * sizeof(int));
+
+    while (1) {
+        if (u == destino) {
+            // Gargalo do caminho atual
+            long long gargalo = FLUXO_INFINITO;
+            for (int i = 0; i < topo; i++) {
+                if (r->residual[pilha[i]] < gargalo) {
+                    gargalo = r->residual[pilha[i]];
+                }
+            }
+
+            // Aplica o fluxo e volta até o primeiro arco saturado
+            int saturado = topo;
+            for (int i = 0; i < topo; i++) {
+                r->residual[pilha[i]] -= gargalo;
+                r->residual[r->reverso[pilha[i]]] += gargalo;
+                if (r->residual[pilha[i]] == 0 && saturado == topo) {
+                    saturado = i;
+                }
+            }
+
+            total += gargalo;
+            topo = saturado;
+            u = (topo == 0) ? origem : r->destino[pilha[topo - 1]];
+            continue;
+        }
+
+        // Avança pelo próximo arco admissível
+        int avancou = 0;
+        while (iterador[u] < r->inicio[u + 1]) {
+            int a = iterador[u];
+            int v = r->destino[a];
+            if (r->residual[a] > 0 && nivel[v] == nivel[u] + 1) {
+                pilha[topo++] = a;
+                u = v;
+                avancou = 1;
+                break;
+            }
+            iterador[u]++;
+        }
+
+        if (avancou) continue;
+
+        // Beco sem saída: remove o nó do grafo de níveis e recua
+        nivel[u] = -1;
+        if (topo == 0) break;
+        topo--;
+        u = (topo == 0) ? origem : r->destino[pilha[topo - 1]];
+        iterador[u]++;
+    }
+
+    return total;
+}
+
+// Calcula a vazão máxima entre um grupo de origens (ex.: servidores) e um grupo
+// de destinos (ex.: computadores), usando as capacidades das conexões.
+// Se 'corte' não for NULL, recebe os pares (origem, destino) das conexões do corte
+// mínimo — deve ter espaço para 2 * contar_arestas(g) inteiros.
+// Retorna a vazão máxima em Mbps ou -1 em caso de erro
+long long calcular_fluxo_maximo(Grafo* g, const int* origens, int num_origens,
+                                const int* destinos, int num_destinos,
+                                int* corte, int* tamanho_corte) {
+    if (!g || !origens || !destinos || num_origens <= 0 || num_destinos <= 0) {
+        return -1;
+    }
+
+    int n = g->num_vertices;
+
+    // Valida os grupos (um dispositivo não pode estar nos dois)
+    char* grupo = (char*)calloc(n, sizeof(char));
+    if (!grupo) return -1;
+
+    for (int i = 0; i < num_origens; i++) {
+        if (origens[i] < 0 || origens[i] >= n) {
+            free(grupo);
+            return -1;
+        }
+        grupo[origens[i]] = 1;
+    }
+    for (int i = 0; i < num_destinos; i++) {
+        if (destinos[i] < 0 || destinos[i] >= n || grupo[destinos[i]] == 1) {
+            free(grupo);
+            return -1;
+        }
+    }
+    free(grupo);
+
+    RedeResidual r;
+    if (!montar_rede_residual(g, &r, origens, num_origens, destinos, num_destinos)) {
+        return -1;
+    }
+
+    int super_origem = n;
+    int super_destino = n + 1;
+
+    int* nivel = (int*)malloc(r.num_nos * sizeof(int));
+    int* fila = (int*)malloc(r.num_nos * sizeof(int));
+    int* iterador = (int*)malloc(r.num_nos * sizeof(int));
+    int* pilha = (int*)malloc(r.num_nos * sizeof(int));
+
+    if (!nivel || !fila || !iterador || !pilha) {
+        free(nivel);
+        free(fila);
+        free(iterador);
+        free(pilha);
+        liberar_rede_residual(&r);
+        return -1;
+    }
+
+    long long fluxo = 0;
+    while (bfs_niveis(&r, super_origem, super_destino, nivel, fila)) {
+        fluxo += fluxo_bloqueante(&r, super_origem, super_destino, nivel, iterador, pilha);
+    }
+
+    // Corte mínimo: conexões que saem do conjunto alcançável na rede residual
+    if (tamanho_corte) {
+        *tamanho_corte = 0;
+    }
+    if (corte && tamanho_corte) {
+        bfs_niveis(&r, super_origem, -1, nivel, fila);
+        for (int u = 0; u < n; u++) {
+            if (nivel[u] < 0) continue;
+            for (int a = r.inicio[u]; a < r.inicio[u + 1]; a++) {
+                int v = r.destino[a];
+                if (v < n && nivel[v] < 0) {
+                    corte[2 * (*tamanho_corte)] = u;
+                    corte[2 * (*tamanho_corte) + 1] = v;
+                    (*tamanho_corte)++;
+                }
+            }
+        }
+    }
+
+    free(nivel);
+    free(fila);
+    free(iterador);
+    free(pilha);
+    liberar_rede_residual(&r);
+
+    return fluxo;
+}
+
+
+// ===== Caminhos mínimos com fila de baldes (algoritmo de Dial) =====
+
+// Os pesos das conexões vão de 0 a 3, então 4 baldes circulares bastam
+#define NUM_BALDES 4
+
+typedef struct {
+    int* itens;
+    int tamanho;
+    int capacidade;
+} Balde;
+
+static int balde_inserir(Balde* b, int v) {
+    if (b->tamanho == b->capacidade) {
+        int nova_capacidade = b->capacidade ? b->capacidade * 2 : 64;
+        int* itens = (int*)realloc(b->itens, nova_capacidade * sizeof(int));
+        if (!itens) return 0;
+        b->itens = itens;
+        b->capacidade = nova_capacidade;
+    }
+    b->itens[b->tamanho++] = v;
+    return 1;
+}
+
+// Fila de prioridade do Dial: os itens saem em ordem de peso. Os baldes guardam a
+// capacidade entre buscas (a mesma fila pode ser reaproveitada); fila_dial_liberar
+// devolve a memória
+typedef struct {
+    Balde baldes[NUM_BALDES];
+    int pendentes;
+    int erro;
+} FilaDial;
+
+// Insere um item com o peso informado (no máximo NUM_BALDES - 1 acima do balde atual)
+static void fila_dial_inserir(FilaDial* f, int item, int peso) {
+    if (f->erro) return;
+    if (!balde_inserir(&f->baldes[peso % NUM_BALDES], item)) {
+        f->erro = 1;
+        return;
+    }
+    f->pendentes++;
+}
+
+// Núcleo do algoritmo: retira os itens em ordem de peso e chama 'expandir' para cada um,
+// que insere os sucessores com fila_dial_inserir e retorna 0 para encerrar a busca.
+// Retorna 0 em caso de erro de memória. A fila fica vazia ao final
+static int fila_dial_executar(FilaDial* f, int (*expandir)(void* contexto, int item, int peso),
+                              void* contexto) {
+    int continuar = 1;
+
+    for (int d = 0; f->pendentes > 0 && continuar && !f->erro; d++) {
+        Balde* b = &f->baldes[d % NUM_BALDES];
+
+        while (b->tamanho > 0 && continuar && !f->erro) {
+            int item = b->itens[--b->tamanho];
+            f->pendentes--;
+            continuar = expandir(contexto, item, d);
+        }
+    }
+
+    int ok = !f->erro;
+    for (int i = 0; i < NUM_BALDES; i++) {
+        f->baldes[i].tamanho = 0;
+    }
+    f->pendentes = 0;
+    f->erro = 0;
+    return ok;
+}
+
+static void fila_dial_liberar(FilaDial* f) {
+    for (int i = 0; i < NUM_BALDES; i++) {
+        free(f->baldes[i].itens);
+        f->baldes[i].itens = NULL;
+        f->baldes[i].capacidade = 0;
+    }
+}
+
+// Busca de menor peso por vértices sobre a fila do Dial. A mesma busca serve ao Grafo,
+// ao grafo mapeado e às versões do histórico: 'vizinhos' percorre as conexões de um
+// vértice e chama busca_dial_relaxar para cada uma
+typedef struct BuscaDial BuscaDial;
+typedef void (*VizinhosDial)(BuscaDial* b, int u, int d);
+
+struct BuscaDial {
+    FilaDial* fila;
+    VizinhosDial vizinhos;
+    const void* dados;  // grafo percorrido por 'vizinhos'
+    int* distancia;     // -1 = ainda não alcançado (inicializado pelo chamador)
+    int* anterior;      // pode ser NULL
+    int* fonte;         // pode ser NULL: origem (índice) mais próxima de cada vértice
+    int* fixados;       // pode ser NULL: vértices na ordem em que foram fixados
+    int destino;        // a busca termina ao fixar este vértice (-1 = busca completa)
+    int alcancados;
+};
+
+static void busca_dial_iniciar(BuscaDial* b, FilaDial* fila, VizinhosDial vizinhos,
+                               const void* dados, int* distancia, int* anterior) {
+    memset(b, 0, sizeof(*b));
+    b->fila = fila;
+    b->vizinhos = vizinhos;
+    b->dados = dados;
+    b->distancia = distancia;
+    b->anterior = anterior;
+    b->destino = -1;
+}
+
+// Acrescenta uma origem (peso 0); 'indice' é o valor gravado em fonte[]
+static void busca_dial_origem(BuscaDial* b, int origem, int indice) {
+    if (b->distancia[origem] == 0) return;
+    b->distancia[origem] = 0;
+    if (b->anterior) b->anterior[origem] = -1;
+    if (b->fonte) b->fonte[origem] = indice;
+    fila_dial_inserir(b->fila, origem, 0);
+}
+
+// Relaxa a conexão u -> v de peso 'peso', com u fixado em 'd'
+static void busca_dial_relaxar(BuscaDial* b, int u, int v, int peso, int d) {
+    int novo_peso = d + peso;
+    if (peso < 0 || peso >= NUM_BALDES) return;
+    if (b->distancia[v] >= 0 && novo_peso >= b->distancia[v]) return;
+
+    b->distancia[v] = novo_peso;
+    if (b->anterior) b->anterior[v] = u;
+    if (b->fonte) b->fonte[v] = b->fonte[u];
+    fila_dial_inserir(b->fila, v, novo_peso);
+}
+
+static int busca_dial_expandir(void* contexto, int u, int d) {
+    BuscaDial* b = (BuscaDial*)contexto;
+
+    // Entrada desatualizada (o vértice já foi fixado com peso menor)
+    if (b->distancia[u] != d) return 1;
+
+    if (b->fixados) b->fixados[b->alcancados] = u;
+    b->alcancados++;
+    if (u == b->destino) return 0;
+
+    b->vizinhos(b, u, d);
+    return 1;
+}
+
+// Executa a busca. Retorna o número de vértices fixados (0 em caso de erro)
+static int busca_dial_executar(BuscaDial* b) {
+    if (!fila_dial_executar(b->fila, busca_dial_expandir, b)) return 0;
+    return b->alcancados;
+}
+
+static void vizinhos_grafo(BuscaDial* b, int u, int d) {
+    const Grafo* g = (const Grafo*)b->dados;
+    for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+        busca_dial_relaxar(b, u, a->destino, obter_peso_conexao(a->tipo), d);
+    }
+}
+
+// Copia para 'caminho' a rota da origem até 'destino' seguindo anterior[].
+// Retorna o tamanho do caminho
+static int montar_caminho(const int* anterior, int destino, int* caminho) {
+    int tamanho = 0;
+    for (int v = destino; v != -1; v = anterior[v]) tamanho++;
+
+    int pos = tamanho - 1;
+    for (int v = destino; v != -1; v = anterior[v]) {
+        caminho[pos--] = v;
+    }
+    return tamanho;
+}
+
+// Dial a partir de várias origens ao mesmo tempo (todas com peso 0).
+// 'fonte' (pode ser NULL) recebe, para cada vértice alcançado, a origem mais próxima
+// (o índice em 'origens'); -1 nos inalcançáveis. Retorna o número de vértices
+// alcançados (0 em caso de erro)
+static int dial_multiplas_origens(Grafo* g, const int* origens, int num_origens,
+                                  int* distancia, int* anterior, int* fonte) {
+    for (int i = 0; i < g->num_vertices; i++) {
+        distancia[i] = -1;
+        if (anterior) anterior[i] = -1;
+        if (fonte) fonte[i] = -1;
+    }
+
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+
+    BuscaDial busca;
+    busca_dial_iniciar(&busca, &fila, vizinhos_grafo, g, distancia, anterior);
+    busca.fonte = fonte;
+
+    for (int k = 0; k < num_origens; k++) {
+        busca_dial_origem(&busca, origens[k], k);
+    }
+
+    int alcancados = busca_dial_executar(&busca);
+    fila_dial_liberar(&fila);
+    return alcancados;
+}
+
+// Calcula o menor peso de 'origem' até todos os vértices
+// distancia[v] = -1 se v é inalcançável; anterior[v] é o vértice anterior no caminho
+// (-1 na origem). 'anterior' pode ser NULL.
+// Retorna o número de vértices alcançados (0 em caso de erro)
+int calcular_distancias(Grafo* g, int origem, int* distancia, int* anterior) {
+    if (!g || !distancia || origem < 0 || origem >= g->num_vertices) {
+        return 0;
+    }
+
+    return dial_multiplas_origens(g, &origem, 1, distancia, anterior, NULL);
+}
+
+// Rota de menor peso entre dois dispositivos (algoritmo de Dial com parada antecipada).
+// Mesma convenção de encontrar_rota_mais_rapida, mas em tempo quase linear; 'peso'
+// (pode ser NULL) recebe o peso total da rota. Retorna 1 se encontrou um caminho
+int encontrar_rota_dial(Grafo* g, int origem, int destino,
+                        int* caminho, int* tamanho_caminho, int* peso) {
+    if (!g || !caminho || !tamanho_caminho ||
+        origem < 0 || destino < 0 ||
+        origem >= g->num_vertices || destino >= g->num_vertices ||
+        origem == destino) {
+        return 0;
+    }
+
+    int n = g->num_vertices;
+    int* distancia = (int*)malloc(n * sizeof(int));
+    int* anterior = (int*)malloc(n * sizeof(int));
+    if (!distancia || !anterior) {
+        free(distancia);
+        free(anterior);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        distancia[i] = -1;
+    }
+
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+
+    // A busca termina assim que o destino é fixado
+    BuscaDial busca;
+    busca_dial_iniciar(&busca, &fila, vizinhos_grafo, g, distancia, anterior);
+    busca.destino = destino;
+    busca_dial_origem(&busca, origem, 0);
+
+    int encontrou = busca_dial_executar(&busca) > 0 && distancia[destino] >= 0;
+    if (encontrou) {
+        *tamanho_caminho = montar_caminho(anterior, destino, caminho);
+        if (peso) *peso = distancia[destino];
+    }
+
+    fila_dial_liberar(&fila);
+    free(distancia);
+    free(anterior);
+
+    return encontrou;
+}
+
+// ===== Simulação de tráfego por eventos discretos =====
+
+// Resolução do relógio da simulação (1 tick = 1 ms)
+#define SIM_TICKS_POR_SEGUNDO 1000.0
+
+// Roda de temporização hierárquica: 4 níveis de 256 posições (cobre 2^32 ticks)
+#define RODA_BITS 8
+#define RODA_POSICOES (1 << RODA_BITS)
+#define RODA_MASCARA (RODA_POSICOES - 1)
+#define RODA_NIVEIS 4
+
+// Tamanho médio de pacote usado no modelo de fila M/M/1
+#define SIM_BITS_POR_PACOTE 12000.0
+
+typedef enum {
+    EVENTO_INICIO_FLUXO,
+    EVENTO_FIM_FLUXO
+} TipoEvento;
+
+typedef struct Evento {
+    unsigned long long tick;
+    TipoEvento tipo;
+    int fluxo;
+    struct Evento* proximo;
+} Evento;
+
+// Bloco de eventos pré-alocados (liberados juntos no fim da simulação)
+typedef struct BlocoEventos {
+    struct BlocoEventos* proximo;
+    Evento eventos[4096];
+} BlocoEventos;
+
+typedef struct {
+    Evento* posicoes[RODA_NIVEIS][RODA_POSICOES];
+    unsigned long long ocupadas_nivel0[RODA_POSICOES / 64]; // mapa de bits das posições não vazias
+    int pendentes_nivel0;
+    long long pendentes;
+    unsigned long long tick_atual;
+    Evento* livres;
+    BlocoEventos* blocos;
+} RodaTemporizacao;
+
+static Evento* roda_novo_evento(RodaTemporizacao* roda) {
+    if (!roda->livres) {
+        BlocoEventos* bloco = (BlocoEventos*)malloc(sizeof(BlocoEventos));
+        if (!bloco) return NULL;
+        bloco->proximo = roda->blocos;
+        roda->blocos = bloco;
+
+        int total = (int)(sizeof(bloco->eventos) / sizeof(bloco->eventos[0]));
+        for (int i = 0; i < total; i++) {
+            bloco->eventos[i].proximo = roda->livres;
+            roda->livres = &bloco->eventos[i];
+        }
+    }
+
+    Evento* e = roda->livres;
+    roda->livres = e->proximo;
+    return e;
+}
+
+// Coloca o evento na posição correspondente ao seu tick (relativo ao tick atual)
+static void roda_encaixar(RodaTemporizacao* roda, Evento* e) {
+    unsigned long long tick = e->tick < roda->tick_atual ? roda->tick_atual : e->tick;
+    unsigned long long delta = tick - roda->tick_atual;
+    int nivel = 0;
+
+    while (nivel < RODA_NIVEIS - 1 &&
+           delta >= (1ULL << (RODA_BITS * (nivel + 1)))) {
+        nivel++;
+    }
+
+    // Eventos além do alcance da roda ficam no último nível e são reencaixados depois
+    if (delta >= (1ULL << (RODA_BITS * RODA_NIVEIS))) {
+        tick = roda->tick_atual + (1ULL << (RODA_BITS * RODA_NIVEIS)) - 1;
+    }
+
+    int posicao = (int)((tick >> (RODA_BITS * nivel)) & RODA_MASCARA);
+    e->proximo = roda->posicoes[nivel][posicao];
+    roda->posicoes[nivel][posicao] = e;
+
+    if (nivel == 0) {
+        roda->pendentes_nivel0++;
+        roda->ocupadas_nivel0[posicao / 64] |= 1ULL << (posicao % 64);
+    }
+}
+
+// Próxima posição ocupada do nível 0 a partir de 'posicao' (-1 se não houver até o fim da volta)
+static int roda_proxima_ocupada(RodaTemporizacao* roda, int posicao) {
+    for (int palavra = posicao / 64; palavra < RODA_POSICOES / 64; palavra++) {
+        unsigned long long bits = roda->ocupadas_nivel0[palavra];
+        if (palavra == posicao / 64) {
+            bits &= ~0ULL << (posicao % 64);
+        }
+        if (bits) {
+            int bit = 0;
+            while (!(bits & 1ULL)) {
+                bits >>= 1;
+                bit++;
+            }
+            return palavra * 64 + bit;
+        }
+    }
+    return -1;
+}
+
+static int roda_agendar(RodaTemporizacao* roda, unsigned long long tick,
+                        TipoEvento tipo, int fluxo) {
+    Evento* e = roda_novo_evento(roda);
+    if (!e) return 0;
+
+    e->tick = tick;
+    e->tipo = tipo;
+    e->fluxo = fluxo;
+    roda_encaixar(roda, e);
+    roda->pendentes++;
+    return 1;
+}
+
+// Redistribui os eventos de uma posição de nível superior nos níveis inferiores
+// Retorna o índice da posição (0 indica que o nível seguinte também deve cascatear)
+static int roda_cascatear(RodaTemporizacao* roda, int nivel) {
+    int posicao = (int)((roda->tick_atual >> (RODA_BITS * nivel)) & RODA_MASCARA);
+    Evento* e = roda->posicoes[nivel][posicao];
+    roda->posicoes[nivel][posicao] = NULL;
+
+    while (e) {
+        Evento* prox = e->proximo;
+        roda_encaixar(roda, e);
+        e = prox;
+    }
+
+    return posicao;
+}
+
+// Retira os eventos que vencem no próximo tick com eventos (NULL se a roda está vazia)
+static Evento* roda_proximos(RodaTemporizacao* roda) {
+    while (roda->pendentes > 0) {
+        int posicao = (int)(roda->tick_atual & RODA_MASCARA);
+
+        if (posicao == 0) {
+            for (int nivel = 1; nivel < RODA_NIVEIS; nivel++) {
+                if (roda_cascatear(roda, nivel) != 0) break;
+            }
+        }
+
+        Evento* lista = roda->posicoes[0][posicao];
+        if (lista) {
+            roda->posicoes[0][posicao] = NULL;
+            roda->ocupadas_nivel0[posicao / 64] &= ~(1ULL << (posicao % 64));
+            int quantidade = 0;
+            for (Evento* e = lista; e; e = e->proximo) quantidade++;
+            roda->pendentes_nivel0 -= quantidade;
+            roda->pendentes -= quantidade;
+            return lista;
+        }
+
+        // Salta direto para a próxima posição ocupada ou para o próximo ponto de cascata
+        int proxima = roda->pendentes_nivel0 > 0 ? roda_proxima_ocupada(roda, posicao) : -1;
+        if (proxima > posicao) {
+            roda->tick_atual += proxima - posicao;
+        } else {
+            roda->tick_atual = (roda->tick_atual | RODA_MASCARA) + 1;
+        }
+    }
+
+    return NULL;
+}
+
+static void roda_liberar_evento(RodaTemporizacao* roda, Evento* e) {
+    e->proximo = roda->livres;
+    roda->livres = e;
+}
+
+// Reordena os eventos de um mesmo tick: fins antes de inícios, mantendo a ordem relativa
+// dentro de cada grupo (a roda não garante ordem entre eventos da mesma posição)
+static Evento* ordenar_eventos_tick(Evento* lista) {
+    Evento* fins = NULL;
+    Evento** fim_fins = &fins;
+    Evento* inicios = NULL;
+    Evento** fim_inicios = &inicios;
+
+    while (lista) {
+        Evento* e = lista;
+        lista = lista->proximo;
+        if (e->tipo == EVENTO_FIM_FLUXO) {
+            *fim_fins = e;
+            fim_fins = &e->proximo;
+        } else {
+            *fim_inicios = e;
+            fim_inicios = &e->proximo;
+        }
+    }
+    *fim_inicios = NULL;
+    *fim_fins = inicios;
+    return fins;
+}
+
+// Estado de um enlace durante a simulação
+typedef struct {
+    double carga;            // Mbps
+    double ultimo_tempo;
+    double integral_carga;   // Mbps * s
+    double integral_atraso;  // s * s
+    double pico;
+    double tempo_saturado;
+} EstadoEnlace;
+
+// Instante de início de um fluxo (usado para ordenar os inícios)
+typedef struct {
+    unsigned long long tick;
+    int fluxo;
+} InicioFluxo;
+
+static int comparar_inicios(const void* a, const void* b) {
+    const InicioFluxo* x = (const InicioFluxo*)a;
+    const InicioFluxo* y = (const InicioFluxo*)b;
+    if (x->tick != y->tick) return x->tick < y->tick ? -1 : 1;
+    return x->fluxo - y->fluxo;
+}
+
+// Atraso de fila (segundos) de um enlace com a carga informada — modelo M/M/1
+static double atraso_fila(double carga, int capacidade) {
+    if (capacidade <= 0 || carga <= 0) return 0.0;
+
+    double utilizacao = carga / capacidade;
+    if (utilizacao >= 1.0) return -1.0;
+
+    double pacotes_por_segundo = capacidade * 1e6 / SIM_BITS_POR_PACOTE;
+    return utilizacao / (pacotes_por_segundo * (1.0 - utilizacao));
+}
+
+// Acumula as estatísticas do enlace até o instante 'tempo'
+static void enlace_acumular(EstadoEnlace* e, int capacidade, double tempo) {
+    double intervalo = tempo - e->ultimo_tempo;
+    if (intervalo <= 0) return;
+
+    e->integral_carga += e->carga * intervalo;
+
+    double atraso = atraso_fila(e->carga, capacidade);
+    if (atraso < 0) {
+        e->tempo_saturado += intervalo;
+    } else {
+        e->integral_atraso += atraso * intervalo;
+    }
+
+    e->ultimo_tempo = tempo;
+}
+
+// Simula os fluxos de tráfego sobre a rede. Cada fluxo segue a rota de menor peso
+// (obter_peso_conexao) e ocupa 'taxa' Mbps em cada enlace do caminho entre
+// 'inicio' e 'inicio + duracao'.
+// Eventos no mesmo tick (1 ms): os fluxos que terminam são retirados antes de os que
+// começam ocuparem os enlaces, então um fluxo não vê a carga de outro que termina no
+// instante em que ele começa. Os inícios simultâneos seguem a ordem dos índices em
+// 'fluxos', e um fluxo que termina no tick em que começou é retirado logo depois de
+// começar.
+// 'enlaces' pode ser NULL; se informado, deve ter espaço para 2 * contar_arestas(g)
+// posições (uma por sentido de cada conexão).
+// Retorna 1 em caso de sucesso, 0 em caso de erro
+int simular_trafego(Grafo* g, const FluxoTrafego* fluxos, int num_fluxos,
+                    ResultadoSimulacao* resultado, UsoEnlace* enlaces) {
+    if (!g || !resultado || (num_fluxos > 0 && !fluxos) || num_fluxos < 0) {
+        return 0;
+    }
+
+    memset(resultado, 0, sizeof(ResultadoSimulacao));
+
+    int n = g->num_vertices;
+    int ok = 0;
+
+    // Índice de cada enlace (sentido u -> v): inicio_enlace[u] + posição na lista de u
+    int* inicio_enlace = (int*)malloc((n + 1) * sizeof(int));
+    int* distancia = (int*)malloc(n * sizeof(int));
+    int* anterior = (int*)malloc(n * sizeof(int));
+    int* ordem = (int*)malloc((num_fluxos + 1) * sizeof(int));
+    int* inicio_rota = (int*)malloc((num_fluxos + 1) * sizeof(int));
+    int* rotas = NULL;
+    int* capacidades = NULL;
+    EstadoEnlace* estados = NULL;
+    InicioFluxo* inicios = NULL;
+    RodaTemporizacao* roda = (RodaTemporizacao*)calloc(1, sizeof(RodaTemporizacao));
+
+    if (!inicio_enlace || !distancia || !anterior || !ordem || !inicio_rota || !roda) {
+        goto fim;
+    }
+
+    inicio_enlace[0] = 0;
+    for (int u = 0; u < n; u++) {
+        int grau = 0;
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) grau++;
+        inicio_enlace[u + 1] = inicio_enlace[u] + grau;
+    }
+    int num_enlaces = inicio_enlace[n];
+
+    capacidades = (int*)malloc((num_enlaces + 1) * sizeof(int));
+    estados = (EstadoEnlace*)calloc(num_enlaces + 1, sizeof(EstadoEnlace));
+    if (!capacidades || !estados) goto fim;
+
+    for (int u = 0; u < n; u++) {
+        int k = inicio_enlace[u];
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+            capacidades[k++] = a->capacidade;
+        }
+    }
+
+    // Ordena os fluxos por origem (contagem) para reaproveitar a árvore de caminhos
+    // mínimos de cada origem; fluxos com origem inválida ficam no grupo 0
+    {
+        int* contagem = (int*)calloc(n + 2, sizeof(int));
+        if (!contagem) goto fim;
+        for (int i = 0; i < num_fluxos; i++) {
+            int o = fluxos[i].origem;
+            contagem[((o >= 0 && o < n) ? o + 1 : 0) + 1]++;
+        }
+        for (int i = 0; i <= n; i++) contagem[i + 1] += contagem[i];
+        for (int i = 0; i < num_fluxos; i++) {
+            int o = fluxos[i].origem;
+            ordem[contagem[(o >= 0 && o < n) ? o + 1 : 0]++] = i;
+        }
+        free(contagem);
+    }
+
+    // Calcula a rota (lista de enlaces) de cada fluxo
+    int capacidade_rotas = 1024;
+    int total_rotas = 0;
+    rotas = (int*)malloc(capacidade_rotas * sizeof(int));
+    if (!rotas) goto fim;
+
+    int origem_calculada = -1;
+    for (int k = 0; k < num_fluxos; k++) {
+        int f = ordem[k];
+        int o = fluxos[f].origem;
+        int d = fluxos[f].destino;
+        inicio_rota[f] = -1;
+
+        if (o < 0 || o >= n || d < 0 || d >= n || o == d ||
+            fluxos[f].taxa < 0 || fluxos[f].duracao < 0 || fluxos[f].inicio < 0) {
+            resultado->fluxos_sem_rota++;
+            continue;
+        }
+
+        if (o != origem_calculada) {
+            calcular_distancias(g, o, distancia, anterior);
+            origem_calculada = o;
+        }
+
+        if (distancia[d] < 0) {
+            resultado->fluxos_sem_rota++;
+            continue;
+        }
+
+        // Percorre o caminho de trás para frente gravando os enlaces (terminados por -1)
+        int saltos = 0;
+        for (int v = d; v != o; v = anterior[v]) saltos++;
+
+        while (total_rotas + saltos + 1 > capacidade_rotas) {
+            capacidade_rotas *= 2;
+            int* novas = (int*)realloc(rotas, capacidade_rotas * sizeof(int));
+            if (!novas) goto fim;
+            rotas = novas;
+        }
+
+        inicio_rota[f] = total_rotas;
+        int pos = total_rotas + saltos - 1;
+        for (int v = d; v != o; v = anterior[v]) {
+            int u = anterior[v];
+            int indice = inicio_enlace[u];
+            for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima, indice++) {
+                if (a->destino == v) break;
+            }
+            rotas[pos--] = indice;
+        }
+        total_rotas += saltos;
+        rotas[total_rotas++] = -1;
+        resultado->fluxos_roteados++;
+    }
+
+    // Ordena os fluxos roteados pelo instante de início. Apenas o próximo início fica
+    // agendado na roda (cada início agenda o seguinte), o que mantém a roda pequena.
+    inicios = (InicioFluxo*)malloc((resultado->fluxos_roteados + 1) * sizeof(InicioFluxo));
+    if (!inicios) goto fim;
+
+    int num_inicios = 0;
+    for (int f = 0; f < num_fluxos; f++) {
+        if (inicio_rota[f] < 0) continue;
+        inicios[num_inicios].tick = (unsigned long long)(fluxos[f].inicio * SIM_TICKS_POR_SEGUNDO);
+        inicios[num_inicios].fluxo = f;
+        num_inicios++;
+    }
+    qsort(inicios, num_inicios, sizeof(InicioFluxo), comparar_inicios);
+
+    // Regrava as rotas na ordem de início para percorrê-las sequencialmente
+    {
+        int* rotas_ordenadas = (int*)malloc((total_rotas + 1) * sizeof(int));
+        if (!rotas_ordenadas) goto fim;
+
+        int pos = 0;
+        for (int k = 0; k < num_inicios; k++) {
+            int f = inicios[k].fluxo;
+            int origem_rota = inicio_rota[f];
+            inicio_rota[f] = pos;
+            do {
+                rotas_ordenadas[pos++] = rotas[origem_rota];
+            } while (rotas[origem_rota++] >= 0);
+        }
+
+        free(rotas);
+        rotas = rotas_ordenadas;
+    }
+
+    int proximo_inicio = 0;
+    if (num_inicios > 0) {
+        if (!roda_agendar(roda, inicios[0].tick, EVENTO_INICIO_FLUXO, inicios[0].fluxo)) goto fim;
+        proximo_inicio = 1;
+    }
+
+    // Laço principal de eventos
+    double soma_latencias = 0.0;
+    double tempo = 0.0;
+    Evento* lista;
+
+    while ((lista = roda_proximos(roda)) != NULL) {
+        tempo = roda->tick_atual / SIM_TICKS_POR_SEGUNDO;
+        lista = ordenar_eventos_tick(lista);
+
+        while (lista) {
+            Evento* e = lista;
+            lista = lista->proximo;
+
+            int f = e->fluxo;
+            const int* rota = &rotas[inicio_rota[f]];
+            double taxa = fluxos[f].taxa;
+
+            if (e->tipo == EVENTO_INICIO_FLUXO) {
+                double latencia = 0.0;
+                for (int i = 0; rota[i] >= 0; i++) {
+                    EstadoEnlace* est = &estados[rota[i]];
+                    enlace_acumular(est, capacidades[rota[i]], tempo);
+                    est->carga += taxa;
+                    if (est->carga > est->pico) est->pico = est->carga;
+
+                    double atraso = atraso_fila(est->carga, capacidades[rota[i]]);
+                    latencia += atraso < 0 ? 1.0 : atraso; // enlace saturado: 1 s por salto
+                }
+
+                latencia *= 1000.0;
+                soma_latencias += latencia;
+                if (latencia > resultado->latencia_maxima_ms) {
+                    resultado->latencia_maxima_ms = latencia;
+                }
+
+                unsigned long long fim_tick = (unsigned long long)
+                    ((fluxos[f].inicio + fluxos[f].duracao) * SIM_TICKS_POR_SEGUNDO);
+                if (!roda_agendar(roda, fim_tick, EVENTO_FIM_FLUXO, f)) goto fim;
+
+                if (proximo_inicio < num_inicios) {
+                    if (!roda_agendar(roda, inicios[proximo_inicio].tick, EVENTO_INICIO_FLUXO,
+                                      inicios[proximo_inicio].fluxo)) {
+                        goto fim;
+                    }
+                    proximo_inicio++;
+                }
+            } else {
+                for (int i = 0; rota[i] >= 0; i++) {
+                    EstadoEnlace* est = &estados[rota[i]];
+                    enlace_acumular(est, capacidades[rota[i]], tempo);
+                    est->carga -= taxa;
+                    if (est->carga < 1e-9) est->carga = 0.0;
+                }
+            }
+
+            roda_liberar_evento(roda, e);
+            resultado->eventos_processados++;
+        }
+    }
+
+    resultado->tempo_simulado = tempo;
+    if (resultado->fluxos_roteados > 0) {
+        resultado->latencia_media_ms = soma_latencias / resultado->fluxos_roteados;
+    }
+
+    if (enlaces) {
+        for (int u = 0; u < n; u++) {
+            int k = inicio_enlace[u];
+            for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima, k++) {
+                EstadoEnlace* est = &estados[k];
+                enlace_acumular(est, capacidades[k], tempo);
+
+                enlaces[k].origem = u;
+                enlaces[k].destino = a->destino;
+                enlaces[k].tipo = a->tipo;
+                enlaces[k].capacidade = capacidades[k];
+                enlaces[k].utilizacao_pico = capacidades[k] > 0 ? est->pico / capacidades[k] : 0.0;
+                enlaces[k].tempo_saturado = est->tempo_saturado;
+
+                if (tempo > 0 && capacidades[k] > 0) {
+                    enlaces[k].utilizacao_media = est->integral_carga / (tempo * capacidades[k]);
+                    enlaces[k].atraso_fila_medio_ms = 1000.0 * est->integral_atraso / tempo;
+                } else {
+                    enlaces[k].utilizacao_media = 0.0;
+                    enlaces[k].atraso_fila_medio_ms = 0.0;
+                }
+            }
+        }
+    }
+
+    ok = 1;
+
+fim:
+    if (roda) {
+        while (roda->blocos) {
+            BlocoEventos* prox = roda->blocos->proximo;
+            free(roda->blocos);
+            roda->blocos = prox;
+        }
+        free(roda);
+    }
+    free(inicio_enlace);
+    free(distancia);
+    free(anterior);
+    free(ordem);
+    free(inicio_rota);
+    free(rotas);
+    free(capacidades);
+    free(estados);
+    free(inicios);
+
+    return ok;
+}
+
+
+// ===== Centralidade de intermediação (algoritmo de Brandes) =====
+
+// Os caminhos mínimos são comparados primeiro pelo peso e depois pelo número de saltos.
+// Sem o desempate, conexões de fibra (peso 0) formariam ciclos de custo zero e a
+// contagem de caminhos mínimos deixaria de ser finita.
+// O custo de uma conexão é peso * num_vertices + 1 (cabe em long long).
+
+typedef struct {
+    long long chave;
+    int vertice;
+} ItemHeap;
+
+// Espaço de trabalho de cada thread
+typedef struct {
+    Grafo* g;
+    const int* fontes;
+    int num_fontes;
+    int* proxima_fonte;          // contador compartilhado (protegido por 'trava')
+    pthread_mutex_t* trava;
+    double* acumulador;          // centralidade parcial desta thread
+    int erro;
+} TrabalhoCentralidade;
+
+static void heap_inserir(ItemHeap* heap, int* tamanho, long long chave, int vertice) {
+    int i = (*tamanho)++;
+    while (i > 0) {
+        int pai = (i - 1) / 2;
+        if (heap[pai].chave <= chave) break;
+        heap[i] = heap[pai];
+        i = pai;
+    }
+    heap[i].chave = chave;
+    heap[i].vertice = vertice;
+}
+
+static ItemHeap heap_remover(ItemHeap* heap, int* tamanho) {
+    ItemHeap topo = heap[0];
+    ItemHeap ultimo = heap[--(*tamanho)];
+    int i = 0;
+
+    while (1) {
+        int filho = 2 * i + 1;
+        if (filho >= *tamanho) break;
+        if (filho + 1 < *tamanho && heap[filho + 1].chave < heap[filho].chave) filho++;
+        if (heap[filho].chave >= ultimo.chave) break;
+        heap[i] = heap[filho];
+        i = filho;
+    }
+    if (*tamanho > 0) heap[i] = ultimo;
+
+    return topo;
+}
+
+static long long custo_centralidade(Grafo* g, TipoConexao tipo) {
+    return (long long)obter_peso_conexao(tipo) * g->num_vertices + 1;
+}
+
+static void* thread_centralidade(void* arg) {
+    TrabalhoCentralidade* t = (TrabalhoCentralidade*)arg;
+    Grafo* g = t->g;
+    int n = g->num_vertices;
+
+    // Cada vértice entra no heap no máximo uma vez por aresta relaxada
+    int max_heap = 2 * contar_arestas(g) + 1;
+
+    long long* distancia = (long long*)malloc(n * sizeof(long long));
+    double* sigma = (double*)malloc(n * sizeof(double));
+    double* delta = (double*)malloc(n * sizeof(double));
+    int* pilha = (int*)malloc(n * sizeof(int));
+    ItemHeap* heap = (ItemHeap*)malloc(max_heap * sizeof(ItemHeap));
+
+    if (!distancia || !sigma || !delta || !pilha || !heap) {
+        t->erro = 1;
+        free(distancia);
+        free(sigma);
+        free(delta);
+        free(pilha);
+        free(heap);
+        return NULL;
+    }
+
+    for (int i = 0; i < n; i++) {
+        distancia[i] = -1;
+        sigma[i] = 0.0;
+        delta[i] = 0.0;
+    }
+
+    while (1) {
+        pthread_mutex_lock(t->trava);
+        int k = (*t->proxima_fonte)++;
+        pthread_mutex_unlock(t->trava);
+        if (k >= t->num_fontes) break;
+
+        int s = t->fontes[k];
+        int topo_pilha = 0;
+        int tamanho_heap = 0;
+
+        // Fase 1: caminhos mínimos a partir de s (Dijkstra), contando caminhos em sigma
+        distancia[s] = 0;
+        sigma[s] = 1.0;
+        heap_inserir(heap, &tamanho_heap, 0, s);
+
+        while (tamanho_heap > 0) {
+            ItemHeap item = heap_remover(heap, &tamanho_heap);
+            int u = item.vertice;
+            if (item.chave != distancia[u]) continue; // entrada desatualizada
+
+            pilha[topo_pilha++] = u;
+
+            for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+                int v = a->destino;
+                long long nova = distancia[u] + custo_centralidade(g, a->tipo);
+
+                if (distancia[v] < 0 || nova < distancia[v]) {
+                    distancia[v] = nova;
+                    sigma[v] = sigma[u];
+                    heap_inserir(heap, &tamanho_heap, nova, v);
+                } else if (nova == distancia[v]) {
+                    sigma[v] += sigma[u];
+                }
+            }
+        }
+
+        // Fase 2: acumula as dependências em ordem decrescente de distância
+        while (topo_pilha > 0) {
+            int w = pilha[--topo_pilha];
+
+            for (Aresta* a = g->vertices[w].lista_adjacencia; a; a = a->proxima) {
+                int v = a->destino;
+                if (distancia[v] >= 0 &&
+                    distancia[v] + custo_centralidade(g, a->tipo) == distancia[w]) {
+                    delta[v] += sigma[v] / sigma[w] * (1.0 + delta[w]);
+                }
+            }
+
+            if (w != s) {
+                t->acumulador[w] += delta[w];
+            }
+
+            // Restaura o estado do vértice para a próxima fonte (os vértices mais
+            // distantes, já processados, nunca são predecessores dos seguintes)
+            distancia[w] = -1;
+            sigma[w] = 0.0;
+            delta[w] = 0.0;
+        }
+    }
+
+    free(distancia);
+    free(sigma);
+    free(delta);
+    free(pilha);
+    free(heap);
+    return NULL;
+}
+
+// Calcula a centralidade de intermediação de cada dispositivo: quantos caminhos
+// mínimos entre outros pares de dispositivos passam por ele.
+// amostras <= 0 ou >= num_vertices: cálculo exato usando todos os vértices como fonte;
+// caso contrário usa 'amostras' fontes aleatórias e escala o resultado (aproximação).
+// num_threads <= 0 usa o número de processadores disponíveis.
+// Retorna 1 em caso de sucesso, 0 em caso de erro
+int calcular_centralidade(Grafo* g, double* centralidade, int amostras, int num_threads) {
+    if (!g || !centralidade) return 0;
+
+    int n = g->num_vertices;
+    for (int i = 0; i < n; i++) {
+        centralidade[i] = 0.0;
+    }
+    if (n < 3) return 1;
+
+    if (num_threads <= 0) {
+        long processadores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = processadores > 0 ? (int)processadores : 1;
+    }
+    if (amostras <= 0 || amostras > n) {
+        amostras = n;
+    }
+    if (num_threads > amostras) {
+        num_threads = amostras;
+    }
+
+    // Escolhe as fontes (embaralhamento parcial de Fisher-Yates com semente fixa,
+    // para que a aproximação seja reproduzível)
+    int* fontes = (int*)malloc(n * sizeof(int));
+    double* acumuladores = (double*)calloc((size_t)n * num_threads, sizeof(double));
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    TrabalhoCentralidade* trabalhos = (TrabalhoCentralidade*)calloc(num_threads, sizeof(TrabalhoCentralidade));
+
+    if (!fontes || !acumuladores || !threads || !trabalhos) {
+        free(fontes);
+        free(acumuladores);
+        free(threads);
+        free(trabalhos);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        fontes[i] = i;
+    }
+    if (amostras < n) {
+        unsigned long long semente = 88172645463325252ULL;
+        for (int i = 0; i < amostras; i++) {
+            semente ^= semente << 13;
+            semente ^= semente >> 7;
+            semente ^= semente << 17;
+            int j = i + (int)(semente % (unsigned long long)(n - i));
+            int temp = fontes[i];
+            fontes[i] = fontes[j];
+            fontes[j] = temp;
+        }
+    }
+
+    pthread_mutex_t trava;
+    pthread_mutex_init(&trava, NULL);
+    int proxima_fonte = 0;
+    int criadas = 0;
+    int ok = 1;
+
+    for (int t = 0; t < num_threads; t++) {
+        trabalhos[t].g = g;
+        trabalhos[t].fontes = fontes;
+        trabalhos[t].num_fontes = amostras;
+        trabalhos[t].proxima_fonte = &proxima_fonte;
+        trabalhos[t].trava = &trava;
+        trabalhos[t].acumulador = &acumuladores[(size_t)t * n];
+
+        if (pthread_create(&threads[t], NULL, thread_centralidade, &trabalhos[t]) != 0) {
+            break;
+        }
+        criadas++;
+    }
+
+    // Se nenhuma thread pôde ser criada, faz o cálculo na thread atual
+    if (criadas == 0) {
+        thread_centralidade(&trabalhos[0]);
+    }
+
+    for (int t = 0; t < criadas; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (trabalhos[t].erro) ok = 0;
+    }
+
+    pthread_mutex_destroy(&trava);
+
+    // Soma os acumuladores; cada par não orientado foi contado nos dois sentidos
+    double escala = (double)n / amostras / 2.0;
+    for (int t = 0; t < num_threads; t++) {
+        for (int i = 0; i < n; i++) {
+            centralidade[i] += acumuladores[(size_t)t * n + i];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        centralidade[i] *= escala;
+    }
+
+    free(fontes);
+    free(acumuladores);
+    free(threads);
+    free(trabalhos);
+
+    return ok;
+}
+
+// Preenche 'ids' com os dispositivos do tipo informado em ordem decrescente de
+// centralidade (no máximo max_ids). Retorna a quantidade preenchida
+int ranquear_centralidade(Grafo* g, const double* centralidade, TipoDispositivo tipo,
+                          int* ids, int max_ids) {
+    if (!g || !centralidade || !ids || max_ids <= 0) return 0;
+
+    int quantidade = 0;
+
+    // Inserção ordenada mantendo apenas os max_ids maiores
+    for (int v = 0; v < g->num_vertices; v++) {
+        if (g->vertices[v].tipo != tipo) continue;
+
+        int pos = quantidade < max_ids ? quantidade : max_ids - 1;
+        if (quantidade == max_ids && centralidade[v] <= centralidade[ids[pos]]) {
+            continue;
+        }
+
+        while (pos > 0 && centralidade[ids[pos - 1]] < centralidade[v]) {
+            ids[pos] = ids[pos - 1];
+            pos--;
+        }
+        ids[pos] = v;
+        if (quantidade < max_ids) quantidade++;
+    }
+
+    return quantidade;
+}
+
+
+// ===== Grafo mapeado em memória (fora do núcleo) =====
+
+#define MAPEADO_ASSINATURA "REDEMAP"
+#define MAPEADO_VERSAO 1
+
+// Grava vértices no formato mapeável: cabeçalho, tabela de vértices e vetor de arcos.
+// Sem 'membros' grava o grafo inteiro com os IDs originais. Com 'membros' (IDs globais na
+// ordem dos novos IDs) grava só os arcos entre vértices com o mesmo particao[] e traduz os
+// destinos por id_local[]. Retorna 1 em caso de sucesso, 0 em caso de erro
+static int gravar_mapeado(Grafo* g, const int* particao, const int* id_local,
+                          const int* membros, int num_membros, const char* caminho) {
+    int p = membros ? particao[membros[0]] : 0;
+
+    long long num_arcos = 0;
+    for (int i = 0; i < num_membros; i++) {
+        for (Aresta* a = g->vertices[membros ? membros[i] : i].lista_adjacencia; a; a = a->proxima) {
+            if (!membros || particao[a->destino] == p) num_arcos++;
+        }
+    }
+
+    FILE* arquivo = fopen(caminho, "wb");
+    if (!arquivo) return 0;
+
+    CabecalhoMapeado cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.assinatura, MAPEADO_ASSINATURA, sizeof(MAPEADO_ASSINATURA));
+    cab.versao = MAPEADO_VERSAO;
+    cab.num_vertices = num_membros;
+    cab.num_arcos = num_arcos;
+    cab.inicio_vertices = sizeof(CabecalhoMapeado);
+    cab.inicio_arcos = cab.inicio_vertices + (long long)num_membros * sizeof(VerticeMapeado);
+
+    int ok = fwrite(&cab, sizeof(cab), 1, arquivo) == 1;
+
+    // Tabela de vértices (primeiro_arco é a soma dos graus anteriores)
+    long long primeiro_arco = 0;
+    for (int i = 0; i < num_membros && ok; i++) {
+        Vertice* vertice = &g->vertices[membros ? membros[i] : i];
+
+        VerticeMapeado v;
+        memset(&v, 0, sizeof(v));
+        v.tipo = vertice->tipo;
+        v.primeiro_arco = primeiro_arco;
+        memcpy(v.nome, vertice->nome, sizeof(v.nome));
+
+        for (Aresta* a = vertice->lista_adjacencia; a; a = a->proxima) {
+            if (!membros || particao[a->destino] == p) v.grau++;
+        }
+        primeiro_arco += v.grau;
+
+        ok = fwrite(&v, sizeof(v), 1, arquivo) == 1;
+    }
+
+    // Vetor de arcos, na mesma ordem das listas de adjacência
+    for (int i = 0; i < num_membros && ok; i++) {
+        for (Aresta* a = g->vertices[membros ? membros[i] : i].lista_adjacencia; a && ok; a = a->proxima) {
+            if (membros && particao[a->destino] != p) continue;
+
+            ArcoMapeado arco;
+            arco.destino = membros ? id_local[a->destino] : a->destino;
+            arco.tipo = a->tipo;
+            arco.capacidade = a->capacidade;
+            ok = fwrite(&arco, sizeof(arco), 1, arquivo) == 1;
+        }
+    }
+
+    if (fclose(arquivo) != 0) ok = 0;
+    return ok;
+}
+
+// Grava o grafo no formato mapeável (ver gravar_mapeado).
+// Retorna 1 em caso de sucesso, 0 em caso de erro
+int exportar_grafo_mapeado(Grafo* g, const char* caminho) {
+    if (!g || !caminho) return 0;
+
+    return gravar_mapeado(g, NULL, NULL, NULL, g->num_vertices, caminho);
+}
+
+// Abre um arquivo gerado por exportar_grafo_mapeado sem carregá-lo na memória
+// Retorna NULL se o arquivo não existir ou for inválido
+GrafoMapeado* abrir_grafo_mapeado(const char* caminho) {
+    if (!caminho) return NULL;
+
+    int descritor = open(caminho, O_RDONLY);
+    if (descritor < 0) return NULL;
+
+    struct stat info;
+    if (fstat(descritor, &info) != 0 || (size_t)info.st_size < sizeof(CabecalhoMapeado)) {
+        close(descritor);
+        return NULL;
+    }
+
+    void* base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, descritor, 0);
+    if (base == MAP_FAILED) {
+        close(descritor);
+        return NULL;
+    }
+
+    // Valida o cabeçalho e os limites das tabelas
+    const CabecalhoMapeado* cab = (const CabecalhoMapeado*)base;
+    long long tamanho = (long long)info.st_size;
+    int valido = memcmp(cab->assinatura, MAPEADO_ASSINATURA, sizeof(MAPEADO_ASSINATURA)) == 0 &&
+        cab->versao == MAPEADO_VERSAO && cab->num_vertices >= 0 && cab->num_arcos >= 0 &&
+        cab->inicio_vertices >= (long long)sizeof(CabecalhoMapeado) &&
+        cab->inicio_arcos >= (long long)sizeof(CabecalhoMapeado) &&
+        cab->inicio_vertices <= tamanho && cab->inicio_arcos <= tamanho &&
+        cab->num_arcos <= tamanho / (long long)sizeof(ArcoMapeado) &&
+        cab->inicio_vertices + (long long)cab->num_vertices * (long long)sizeof(VerticeMapeado) <= tamanho &&
+        cab->inicio_arcos + cab->num_arcos * (long long)sizeof(ArcoMapeado) <= tamanho &&
+        cab->inicio_vertices % (long long)_Alignof(VerticeMapeado) == 0 &&
+        cab->inicio_arcos % (long long)_Alignof(ArcoMapeado) == 0;
+
+    // A tabela de vértices não é percorrida aqui (as páginas seriam todas carregadas): o
+    // intervalo de arcos de cada vértice é conferido no acesso (arcos_mapeados_validos)
+
+    if (!valido) {
+        munmap(base, (size_t)info.st_size);
+        close(descritor);
+        return NULL;
+    }
+
+    GrafoMapeado* gm = (GrafoMapeado*)malloc(sizeof(GrafoMapeado));
+    if (!gm) {
+        munmap(base, (size_t)info.st_size);
+        close(descritor);
+        return NULL;
+    }
+
+    gm->descritor = descritor;
+    gm->base = base;
+    gm->tamanho = (size_t)info.st_size;
+    gm->num_vertices = cab->num_vertices;
+    gm->num_arcos = cab->num_arcos;
+    gm->vertices = (const VerticeMapeado*)((const char*)base + cab->inicio_vertices);
+    gm->arcos = (const ArcoMapeado*)((const char*)base + cab->inicio_arcos);
+
+    return gm;
+}
+
+// Libera o mapeamento e fecha o arquivo
+void fechar_grafo_mapeado(GrafoMapeado* gm) {
+    if (!gm) return;
+
+    munmap(gm->base, gm->tamanho);
+    close(gm->descritor);
+    free(gm);
+}
+
+// Avisa o SO que o arquivo será percorrido do início ao fim (leitura antecipada agressiva).
+// Deve ser chamada antes de varreduras completas (listagens, Mermaid)
+void preparar_varredura_mapeado(GrafoMapeado* gm) {
+    if (!gm) return;
+    posix_madvise(gm->base, gm->tamanho, POSIX_MADV_SEQUENTIAL);
+    posix_madvise(gm->base, gm->tamanho, POSIX_MADV_WILLNEED);
+}
+
+// Confere se o intervalo de arcos do vértice está dentro do vetor de arcos (sem estouro
+// na soma primeiro_arco + grau)
+static int arcos_mapeados_validos(const GrafoMapeado* gm, const VerticeMapeado* v) {
+    return v->primeiro_arco >= 0 && v->grau >= 0 && v->primeiro_arco <= gm->num_arcos &&
+           v->grau <= gm->num_arcos - v->primeiro_arco;
+}
+
+// Copia um grafo mapeado para a memória, mantendo a ordem das listas de adjacência e a
+// capacidade de cada enlace. folga = posições reservadas para novos dispositivos.
+// Retorna NULL em caso de erro ou se o arquivo tiver um tipo ou arco inválido
+Grafo* importar_grafo_mapeado(GrafoMapeado* gm, int folga) {
+    if (!gm || folga < 0 || gm->num_vertices > INT_MAX - folga) return NULL;
+
+    int capacidade = gm->num_vertices + folga;
+    Grafo* g = criar_grafo(capacidade > 0 ? capacidade : 1);
+    if (!g) return NULL;
+
+    int ok = 0;
+
+    preparar_varredura_mapeado(gm);
+    for (int i = 0; i < gm->num_vertices; i++) {
+        const VerticeMapeado* v = &gm->vertices[i];
+        if (v->tipo < SERVIDOR || v->tipo > ACCESS_POINT || !arcos_mapeados_validos(gm, v)) goto fim;
+
+        g->vertices[i].tipo = (TipoDispositivo)v->tipo;
+        memcpy(g->vertices[i].nome, v->nome, sizeof(g->vertices[i].nome));
+        g->vertices[i].nome[sizeof(g->vertices[i].nome) - 1] = '\0';
+        g->num_vertices++;
+
+        // Insere do último para o primeiro, pois as arestas novas entram no início da lista
+        for (int k = v->grau - 1; k >= 0; k--) {
+            const ArcoMapeado* arco = &gm->arcos[v->primeiro_arco + k];
+            if (arco->destino < 0 || arco->destino >= gm->num_vertices || arco->destino == i ||
+                arco->tipo < SATELITE || arco->tipo > FIBRA) {
+                goto fim;
+            }
+
+            Aresta* a = (Aresta*)malloc(sizeof(Aresta));
+            if (!a) goto fim;
+            a->destino = arco->destino;
+            a->tipo = (TipoConexao)arco->tipo;
+            a->capacidade = arco->capacidade;
+            a->proxima = g->vertices[i].lista_adjacencia;
+            g->vertices[i].lista_adjacencia = a;
+        }
+    }
+
+    ok = 1;
+
+fim:
+    if (!ok) {
+        destruir_grafo(g);
+        return NULL;
+    }
+    return g;
+}
+
+// Conexões de um vértice do grafo mapeado (arcos fora dos limites são ignorados)
+static void vizinhos_mapeado(BuscaDial* b, int u, int d) {
+    const GrafoMapeado* gm = (const GrafoMapeado*)b->dados;
+    const VerticeMapeado* vu = &gm->vertices[u];
+    if (!arcos_mapeados_validos(gm, vu)) return;
+
+    for (int i = 0; i < vu->grau; i++) {
+        const ArcoMapeado* arco = &gm->arcos[vu->primeiro_arco + i];
+        if (arco->destino >= 0 && arco->destino < gm->num_vertices) {
+            busca_dial_relaxar(b, u, arco->destino, obter_peso_conexao((TipoConexao)arco->tipo), d);
+        }
+    }
+}
+
+// Versão somente leitura da busca de rota sobre o grafo mapeado (algoritmo de Dial)
+// Mesma convenção de encontrar_rota_dial: 'peso' (pode ser NULL) recebe o peso total da
+// rota. Retorna 1 se encontrou um caminho
+int encontrar_rota_mapeado(GrafoMapeado* gm, int origem, int destino,
+                           int* caminho, int* tamanho_caminho, int* peso) {
+    if (!gm || !caminho || !tamanho_caminho ||
+        origem < 0 || destino < 0 ||
+        origem >= gm->num_vertices || destino >= gm->num_vertices ||
+        origem == destino) {
+        return 0;
+    }
+
+    int n = gm->num_vertices;
+    int* distancia = (int*)malloc(n * sizeof(int));
+    int* anterior = (int*)malloc(n * sizeof(int));
+    if (!distancia || !anterior) {
+        free(distancia);
+        free(anterior);
+        return 0;
+    }
+
+    // Acesso aleatório: evita leitura antecipada desnecessária
+    posix_madvise(gm->base, gm->tamanho, POSIX_MADV_RANDOM);
+
+    for (int i = 0; i < n; i++) {
+        distancia[i] = -1;
+    }
+
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+
+    // A busca termina assim que o destino é fixado
+    BuscaDial busca;
+    busca_dial_iniciar(&busca, &fila, vizinhos_mapeado, gm, distancia, anterior);
+    busca.destino = destino;
+    busca_dial_origem(&busca, origem, 0);
+
+    int encontrou = busca_dial_executar(&busca) > 0 && distancia[destino] >= 0;
+    if (encontrou) {
+        *tamanho_caminho = montar_caminho(anterior, destino, caminho);
+        if (peso) *peso = distancia[destino];
+    }
+
+    fila_dial_liberar(&fila);
+    free(distancia);
+    free(anterior);
+
+    posix_madvise(gm->base, gm->tamanho, POSIX_MADV_NORMAL);
+
+    return encontrou;
+}
+
+// Menor peso de 'origem' até todos os vértices do grafo mapeado (algoritmo de Dial).
+// Mesma convenção de calcular_distancias: distancia[v] = -1 se v é inalcançável.
+// Retorna o número de vértices alcançados (0 em caso de erro)
+int calcular_distancias_mapeado(GrafoMapeado* gm, int origem, int* distancia) {
+    if (!gm || !distancia || origem < 0 || origem >= gm->num_vertices) {
+        return 0;
+    }
+
+    for (int i = 0; i < gm->num_vertices; i++) {
+        distancia[i] = -1;
+    }
+
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+
+    BuscaDial busca;
+    busca_dial_iniciar(&busca, &fila, vizinhos_mapeado, gm, distancia, NULL);
+    busca_dial_origem(&busca, origem, 0);
+
+    int alcancados = busca_dial_executar(&busca);
+    fila_dial_liberar(&fila);
+    return alcancados;
+}
+
+// Versão somente leitura de gerar_mermaid sobre o grafo mapeado
+void gerar_mermaid_mapeado(GrafoMapeado* gm, FILE* arquivo) {
+    if (!gm || !arquivo) return;
+
+    preparar_varredura_mapeado(gm);
+
+    fprintf(arquivo, "graph TD\n");
+
+    for (int i = 0; i < gm->num_vertices; i++) {
+        fprintf(arquivo, "    %d[\"%.*s\"]\n",
+                i, (int)sizeof(gm->vertices[i].nome), gm->vertices[i].nome);
+    }
+
+    for (int i = 0; i < gm->num_vertices; i++) {
+        const VerticeMapeado* v = &gm->vertices[i];
+        if (!arcos_mapeados_validos(gm, v)) continue;
+
+        for (int k = 0; k < v->grau; k++) {
+            const ArcoMapeado* arco = &gm->arcos[v->primeiro_arco + k];
+            if (i < arco->destino) {
+                fprintf(arquivo, "    %d -- %s --- %d\n",
+                        i, tipo_conexao_str((TipoConexao)arco->tipo), arco->destino);
+            }
+        }
+    }
+
+    posix_madvise(gm->base, gm->tamanho, POSIX_MADV_NORMAL);
+}
+
+
+// ===== Reordenação de vértices para localidade =====
+
+typedef struct {
+    int grau;
+    int vertice;
+} VizinhoGrau;
+
+// Conexão original associada ao novo índice do destino (usada ao reconstruir as listas)
+typedef struct {
+    int destino;
+    Aresta* original;
+} ArestaTraduzida;
+
+static int comparar_aresta_traduzida(const void* a, const void* b) {
+    const ArestaTraduzida* x = (const ArestaTraduzida*)a;
+    const ArestaTraduzida* y = (const ArestaTraduzida*)b;
+    return x->destino - y->destino;
+}
+
+static int comparar_vizinho_grau(const void* a, const void* b) {
+    const VizinhoGrau* x = (const VizinhoGrau*)a;
+    const VizinhoGrau* y = (const VizinhoGrau*)b;
+    if (x->grau != y->grau) return x->grau - y->grau;
+    return x->vertice - y->vertice;
+}
+
+// Ordem Reverse Cuthill-McKee: BFS por componente, partindo do vértice de menor grau e
+// visitando os vizinhos em ordem crescente de grau; a ordem final é invertida.
+// ordem[k] = vértice antigo que ficará na posição k
+static int ordem_rcm(Grafo* g, const int* grau, int* ordem) {
+    int n = g->num_vertices;
+    char* visitado = (char*)calloc(n, sizeof(char));
+    VizinhoGrau* candidatos = (VizinhoGrau*)malloc(n * sizeof(VizinhoGrau));
+    if (!visitado || !candidatos) {
+        free(visitado);
+        free(candidatos);
+        return 0;
+    }
+
+    // Candidatos a início de componente, em ordem crescente de grau
+    for (int i = 0; i < n; i++) {
+        candidatos[i].grau = grau[i];
+        candidatos[i].vertice = i;
+    }
+    qsort(candidatos, n, sizeof(VizinhoGrau), comparar_vizinho_grau);
+
+    // Buffer para ordenar os vizinhos de cada vértice por grau
+    VizinhoGrau* vizinhos = (VizinhoGrau*)malloc(n * sizeof(VizinhoGrau));
+    if (!vizinhos) {
+        free(visitado);
+        free(candidatos);
+        return 0;
+    }
+
+    int total = 0;
+    for (int c = 0; c < n; c++) {
+        int inicio = candidatos[c].vertice;
+        if (visitado[inicio]) continue;
+
+        // A própria ordem serve de fila da BFS
+        int frente = total;
+        visitado[inicio] = 1;
+        ordem[total++] = inicio;
+
+        while (frente < total) {
+            int u = ordem[frente++];
+            int k = 0;
+            for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+                if (!visitado[a->destino]) {
+                    visitado[a->destino] = 1;
+                    vizinhos[k].grau = grau[a->destino];
+                    vizinhos[k].vertice = a->destino;
+                    k++;
+                }
+            }
+            qsort(vizinhos, k, sizeof(VizinhoGrau), comparar_vizinho_grau);
+            for (int i = 0; i < k; i++) {
+                ordem[total++] = vizinhos[i].vertice;
+            }
+        }
+    }
+
+    // Inverte a ordem (o "reverse" do RCM)
+    for (int i = 0, j = n - 1; i < j; i++, j--) {
+        int temp = ordem[i];
+        ordem[i] = ordem[j];
+        ordem[j] = temp;
+    }
+
+    free(visitado);
+    free(candidatos);
+    free(vizinhos);
+    return 1;
+}
+
+// Coloca na ordem os vizinhos ainda não posicionados de 'u' que sejam do tipo informado
+static void posicionar_vizinhos(Grafo* g, int u, TipoDispositivo tipo,
+                                char* posicionado, int* ordem, int* total) {
+    for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+        int v = a->destino;
+        if (!posicionado[v] && g->vertices[v].tipo == tipo) {
+            posicionado[v] = 1;
+            ordem[(*total)++] = v;
+        }
+    }
+}
+
+// Ordem hierárquica: switches na ordem de uma BFS pela rede; após cada switch vêm seus
+// servidores, seus access points (cada um seguido de seus computadores) e seus computadores.
+// Dispositivos que não ficam sob nenhum switch vão para o final, na ordem original
+static int ordem_hierarquia(Grafo* g, int* ordem) {
+    int n = g->num_vertices;
+    char* visitado = (char*)calloc(n, sizeof(char));
+    char* posicionado = (char*)calloc(n, sizeof(char));
+    int* fila = (int*)malloc(n * sizeof(int));
+    if (!visitado || !posicionado || !fila) {
+        free(visitado);
+        free(posicionado);
+        free(fila);
+        return 0;
+    }
+
+    int total = 0;
+    for (int inicio = 0; inicio < n; inicio++) {
+        if (visitado[inicio]) continue;
+
+        int frente = 0, fim = 0;
+        visitado[inicio] = 1;
+        fila[fim++] = inicio;
+
+        while (frente < fim) {
+            int u = fila[frente++];
+
+            if (g->vertices[u].tipo == SWITCH && !posicionado[u]) {
+                posicionado[u] = 1;
+                ordem[total++] = u;
+
+                posicionar_vizinhos(g, u, SERVIDOR, posicionado, ordem, &total);
+
+                // Cada access point é seguido imediatamente por seus computadores
+                for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+                    int ap = a->destino;
+                    if (posicionado[ap] || g->vertices[ap].tipo != ACCESS_POINT) continue;
+                    posicionado[ap] = 1;
+                    ordem[total++] = ap;
+                    posicionar_vizinhos(g, ap, COMPUTADOR, posicionado, ordem, &total);
+                }
+
+                posicionar_vizinhos(g, u, COMPUTADOR, posicionado, ordem, &total);
+            }
+
+            for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+                if (!visitado[a->destino]) {
+                    visitado[a->destino] = 1;
+                    fila[fim++] = a->destino;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (!posicionado[i]) {
+            ordem[total++] = i;
+        }
+    }
+
+    free(visitado);
+    free(posicionado);
+    free(fila);
+    return 1;
+}
+
+// Renumera os vértices para que dispositivos vizinhos na topologia fiquem próximos em
+// 'vertices' e reconstrói as listas de adjacência (nós alocados em sequência e ordenados
+// pelo destino), reduzindo falhas de cache nas buscas e varreduras.
+// O campo 'id' de cada vértice passa a ser o novo índice e a tradução de IDs externos do
+// grafo acompanha a nova numeração (ver resolver_id_externo). Se 'novo_id' não for NULL,
+// recebe novo_id[índice antigo] = índice novo.
+// Retorna 1 em caso de sucesso, 0 em caso de erro (a numeração não é alterada)
+int reordenar_vertices(Grafo* g, CriterioReordenacao criterio, int* novo_id) {
+    if (!g) return 0;
+
+    int n = g->num_vertices;
+    if (n == 0) return 1;
+
+    int* ordem = (int*)malloc(n * sizeof(int));
+    int* traducao = (int*)malloc(n * sizeof(int));
+    int* grau = (int*)calloc(n, sizeof(int));
+    Vertice* novos = (Vertice*)malloc(n * sizeof(Vertice));
+    int* externos = (int*)malloc(n * sizeof(int));
+    ArestaTraduzida* destinos = NULL;
+    int ok = 0;
+
+    if (!ordem || !traducao || !grau || !novos || !externos || !criar_ids_externos(g)) goto fim;
+
+    int grau_maximo = 0;
+    for (int i = 0; i < n; i++) {
+        for (Aresta* a = g->vertices[i].lista_adjacencia; a; a = a->proxima) grau[i]++;
+        if (grau[i] > grau_maximo) grau_maximo = grau[i];
+    }
+
+    if (criterio == REORDENAR_RCM) {
+        if (!ordem_rcm(g, grau, ordem)) goto fim;
+    } else {
+        if (!ordem_hierarquia(g, ordem)) goto fim;
+    }
+
+    for (int k = 0; k < n; k++) {
+        traducao[ordem[k]] = k;
+    }
+
+    destinos = (ArestaTraduzida*)malloc((grau_maximo + 1) * sizeof(ArestaTraduzida));
+    if (!destinos) goto fim;
+
+    // Monta as novas listas antes de liberar as antigas, para que os novos nós sejam
+    // alocados em sequência em vez de reaproveitar os buracos deixados pelos antigos
+    for (int k = 0; k < n; k++) {
+        int antigo = ordem[k];
+        novos[k] = g->vertices[antigo];
+        novos[k].id = k;
+        novos[k].lista_adjacencia = NULL;
+
+        int m = 0;
+        for (Aresta* a = g->vertices[antigo].lista_adjacencia; a; a = a->proxima) {
+            destinos[m].destino = traducao[a->destino];
+            destinos[m].original = a;
+            m++;
+        }
+        qsort(destinos, m, sizeof(ArestaTraduzida), comparar_aresta_traduzida);
+
+        Aresta* ultima = NULL;
+        for (int i = 0; i < m; i++) {
+            Aresta* nova = (Aresta*)malloc(sizeof(Aresta));
+            if (!nova) {
+                // Desfaz as listas já criadas
+                for (int j = 0; j <= k; j++) {
+                    Aresta* atual = novos[j].lista_adjacencia;
+                    while (atual) {
+                        Aresta* prox = atual->proxima;
+                        free(atual);
+                        atual = prox;
+                    }
+                }
+                goto fim;
+            }
+
+            nova->destino = destinos[i].destino;
+            nova->tipo = destinos[i].original->tipo;
+            nova->capacidade = destinos[i].original->capacidade;
+            nova->proxima = NULL;
+
+            if (ultima) {
+                ultima->proxima = nova;
+            } else {
+                novos[k].lista_adjacencia = nova;
+            }
+            ultima = nova;
+        }
+    }
+
+    // Libera as listas antigas e instala os vértices na nova ordem
+    for (int i = 0; i < n; i++) {
+        Aresta* atual = g->vertices[i].lista_adjacencia;
+        while (atual) {
+            Aresta* prox = atual->proxima;
+            free(atual);
+            atual = prox;
+        }
+    }
+    memcpy(g->vertices, novos, n * sizeof(Vertice));
+
+    // Compõe a tradução de IDs externos com a nova numeração
+    for (int k = 0; k < n; k++) {
+        externos[k] = g->id_externo[ordem[k]];
+    }
+    memcpy(g->id_externo, externos, n * sizeof(int));
+    for (int e = 0; e < g->num_externos; e++) {
+        if (g->indice_externo[e] >= 0) g->indice_externo[e] = traducao[g->indice_externo[e]];
+    }
+
+    if (novo_id) {
+        memcpy(novo_id, traducao, n * sizeof(int));
+    }
+    ok = 1;
+
+fim:
+    free(ordem);
+    free(traducao);
+    free(grau);
+    free(novos);
+    free(externos);
+    free(destinos);
+    return ok;
+}
+
+// Aplica uma numeração qualquer (novo_id[índice antigo] = índice novo, uma permutação)
+// trocando os vértices de lugar ao longo dos ciclos da permutação, sem reconstruir as
+// listas. Não aloca memória quando a tradução de IDs externos já existe (sempre o caso
+// depois de reordenar_vertices), então serve para desfazer uma reordenação com a
+// permutação inversa. 'novo_id' é marcado durante o percurso e restaurado no final.
+// Retorna 1 em caso de sucesso, 0 se 'novo_id' não for uma permutação ou faltar memória
+int renumerar_vertices(Grafo* g, int* novo_id) {
+    if (!g || !novo_id) return 0;
+
+    int n = g->num_vertices;
+
+    // Confere a permutação: valores no intervalo e cada destino usado uma vez (marcado com ~)
+    for (int i = 0; i < n; i++) {
+        if (novo_id[i] < 0 || novo_id[i] >= n) return 0;
+    }
+    int valida = 1;
+    for (int i = 0; i < n && valida; i++) {
+        int destino = novo_id[i] < 0 ? ~novo_id[i] : novo_id[i];
+        if (novo_id[destino] < 0) {
+            valida = 0;
+        } else {
+            novo_id[destino] = ~novo_id[destino];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (novo_id[i] < 0) novo_id[i] = ~novo_id[i];
+    }
+    if (!valida || !criar_ids_externos(g)) return 0;
+
+    for (int i = 0; i < n; i++) {
+        if (novo_id[i] < 0) continue; // já posicionado
+
+        Vertice atual = g->vertices[i];
+        int externo = g->id_externo[i];
+        int j = novo_id[i];
+        novo_id[i] = ~novo_id[i];
+        while (j != i) {
+            Vertice proximo = g->vertices[j];
+            int proximo_externo = g->id_externo[j];
+            g->vertices[j] = atual;
+            g->id_externo[j] = externo;
+            atual = proximo;
+            externo = proximo_externo;
+
+            int k = novo_id[j];
+            novo_id[j] = ~k;
+            j = k;
+        }
+        g->vertices[i] = atual;
+        g->id_externo[i] = externo;
+    }
+    for (int i = 0; i < n; i++) {
+        novo_id[i] = ~novo_id[i];
+    }
+
+    for (int i = 0; i < n; i++) {
+        g->vertices[i].id = i;
+        for (Aresta* a = g->vertices[i].lista_adjacencia; a; a = a->proxima) {
+            a->destino = novo_id[a->destino];
+        }
+    }
+    for (int e = 0; e < g->num_externos; e++) {
+        if (g->indice_externo[e] >= 0) g->indice_externo[e] = novo_id[g->indice_externo[e]];
+    }
+    return 1;
+}
+
+// ID externo do dispositivo de índice 'indice' (igual ao índice antes da primeira
+// reordenação). Retorna -1 se o índice for inválido
+int obter_id_externo(Grafo* g, int indice) {
+    if (!g || indice < 0 || indice >= g->num_vertices) return -1;
+
+    return g->indice_externo ? g->id_externo[indice] : indice;
+}
+
+// Índice atual do dispositivo com o ID externo informado.
+// Retorna -1 se o ID nunca existiu ou o dispositivo foi removido
+int resolver_id_externo(Grafo* g, int externo) {
+    if (!g || externo < 0) return -1;
+
+    if (!g->indice_externo) return externo < g->num_vertices ? externo : -1;
+    return externo < g->num_externos ? g->indice_externo[externo] : -1;
+}
+
+
+// ===== Árvores de distribuição (árvore geradora mínima e árvore de Steiner) =====
+
+// Os pesos vão de 0 a 3, então as conexões são ordenadas por contagem (um balde por peso)
+// e o Kruskal roda em tempo quase linear com união-busca
+
+static int uniao_encontrar(int* pai, int x) {
+    while (pai[x] != x) {
+        pai[x] = pai[pai[x]];
+        x = pai[x];
+    }
+    return x;
+}
+
+// Une os conjuntos de 'a' e 'b'; retorna 0 se já estavam no mesmo conjunto
+static int uniao_unir(int* pai, int* posto, int a, int b) {
+    a = uniao_encontrar(pai, a);
+    b = uniao_encontrar(pai, b);
+    if (a == b) return 0;
+
+    if (posto[a] < posto[b]) {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    pai[b] = a;
+    if (posto[a] == posto[b]) posto[a]++;
+    return 1;
+}
+
+// Árvore (floresta, se a rede for desconexa) geradora de peso mínimo.
+// 'arestas' deve ter espaço para num_vertices - 1 itens; 'peso_total' pode ser NULL.
+// Retorna o número de componentes da floresta (0 se a rede está vazia) ou -1 em caso de erro
+int calcular_arvore_geradora(Grafo* g, ArestaArvore* arestas, int* num_arestas, int* peso_total) {
+    if (!g || !arestas || !num_arestas) return -1;
+
+    int n = g->num_vertices;
+    *num_arestas = 0;
+    if (peso_total) *peso_total = 0;
+    if (n == 0) return 0;
+
+    int* pai = (int*)malloc(n * sizeof(int));
+    int* posto = (int*)calloc(n, sizeof(int));
+    ArestaArvore* ordenadas = (ArestaArvore*)malloc((contar_arestas(g) + 1) * sizeof(ArestaArvore));
+    int componentes = -1;
+
+    if (!pai || !posto || !ordenadas) goto fim;
+
+    // Ordenação por contagem: conta as conexões de cada peso e calcula o início de cada balde
+    int inicio[NUM_BALDES + 1] = {0};
+    for (int i = 0; i < n; i++) {
+        for (Aresta* a = g->vertices[i].lista_adjacencia; a; a = a->proxima) {
+            int peso = obter_peso_conexao(a->tipo);
+            if (i < a->destino && peso < NUM_BALDES) inicio[peso + 1]++;
+        }
+    }
+    for (int p = 0; p < NUM_BALDES; p++) {
+        inicio[p + 1] += inicio[p];
+    }
+    int total = inicio[NUM_BALDES];
+
+    for (int i = 0; i < n; i++) {
+        for (Aresta* a = g->vertices[i].lista_adjacencia; a; a = a->proxima) {
+            int peso = obter_peso_conexao(a->tipo);
+            if (i < a->destino && peso < NUM_BALDES) {
+                ArestaArvore* e = &ordenadas[inicio[peso]++];
+                e->origem = i;
+                e->destino = a->destino;
+                e->tipo = a->tipo;
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        pai[i] = i;
+    }
+
+    componentes = n;
+    for (int k = 0; k < total && componentes > 1; k++) {
+        if (uniao_unir(pai, posto, ordenadas[k].origem, ordenadas[k].destino)) {
+            arestas[(*num_arestas)++] = ordenadas[k];
+            if (peso_total) *peso_total += obter_peso_conexao(ordenadas[k].tipo);
+            componentes--;
+        }
+    }
+
+fim:
+    free(pai);
+    free(posto);
+    free(ordenadas);
+    return componentes;
+}
+
+// Tipo da conexão entre u e v (usado para reconstruir os caminhos da busca)
+static TipoConexao tipo_conexao_entre(Grafo* g, int u, int v) {
+    for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+        if (a->destino == v) return a->tipo;
+    }
+    return FIBRA;
+}
+
+// Árvore de distribuição aproximada (árvore de Steiner) ligando os 'terminais', por
+// exemplo os servidores e os computadores. Usa a construção de Mehlhorn: um Dial a partir
+// de todos os terminais divide a rede em regiões (terminal mais próximo), cada conexão
+// entre regiões vira uma ligação entre terminais e o Kruskal sobre essas ligações escolhe
+// quais caminhos entram na árvore. O peso fica no máximo 2x o da árvore ótima.
+// 'arestas' deve ter espaço para num_vertices - 1 itens; 'peso_total' pode ser NULL.
+// Retorna 1 se todos os terminais ficaram conectados, 0 caso contrário (as conexões
+// devolvidas ligam apenas os terminais alcançáveis entre si) ou -1 em caso de erro
+int calcular_arvore_distribuicao(Grafo* g, const int* terminais, int num_terminais,
+                                 ArestaArvore* arestas, int* num_arestas, int* peso_total) {
+    if (!g || !terminais || num_terminais <= 0 || !arestas || !num_arestas) return -1;
+
+    int n = g->num_vertices;
+    *num_arestas = 0;
+    if (peso_total) *peso_total = 0;
+
+    for (int k = 0; k < num_terminais; k++) {
+        if (terminais[k] < 0 || terminais[k] >= n) return -1;
+    }
+
+    int* distancia = (int*)malloc(n * sizeof(int));
+    int* anterior = (int*)malloc(n * sizeof(int));
+    int* fonte = (int*)malloc(n * sizeof(int));
+    char* na_arvore = (char*)calloc(n, sizeof(char));
+    int* pai = (int*)malloc(num_terminais * sizeof(int));
+    int* posto = (int*)calloc(num_terminais, sizeof(int));
+    int* contagem = NULL;
+    ArestaArvore* ligacoes = NULL;
+    int conectado = -1;
+
+    if (!distancia || !anterior || !fonte || !na_arvore || !pai || !posto) goto fim;
+
+    if (!dial_multiplas_origens(g, terminais, num_terminais, distancia, anterior, fonte)) goto fim;
+
+    // Conexões entre regiões; o custo da ligação é d(u) + peso + d(v)
+    int custo_maximo = 0;
+    int num_ligacoes = 0;
+    for (int u = 0; u < n; u++) {
+        if (fonte[u] < 0) continue;
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+            int v = a->destino;
+            int peso = obter_peso_conexao(a->tipo);
+            if (u < v && fonte[v] >= 0 && fonte[u] != fonte[v] && peso < NUM_BALDES) {
+                int custo = distancia[u] + peso + distancia[v];
+                if (custo > custo_maximo) custo_maximo = custo;
+                num_ligacoes++;
+            }
+        }
+    }
+
+    contagem = (int*)calloc(custo_maximo + 2, sizeof(int));
+    ligacoes = (ArestaArvore*)malloc((num_ligacoes + 1) * sizeof(ArestaArvore));
+    if (!contagem || !ligacoes) goto fim;
+
+    // Ordenação por contagem das ligações pelo custo (limitado a ~6 * num_vertices)
+    for (int u = 0; u < n; u++) {
+        if (fonte[u] < 0) continue;
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+            int v = a->destino;
+            int peso = obter_peso_conexao(a->tipo);
+            if (u < v && fonte[v] >= 0 && fonte[u] != fonte[v] && peso < NUM_BALDES) {
+                contagem[distancia[u] + peso + distancia[v] + 1]++;
+            }
+        }
+    }
+    for (int c = 0; c <= custo_maximo; c++) {
+        contagem[c + 1] += contagem[c];
+    }
+    for (int u = 0; u < n; u++) {
+        if (fonte[u] < 0) continue;
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+            int v = a->destino;
+            int peso = obter_peso_conexao(a->tipo);
+            if (u < v && fonte[v] >= 0 && fonte[u] != fonte[v] && peso < NUM_BALDES) {
+                ArestaArvore* e = &ligacoes[contagem[distancia[u] + peso + distancia[v]]++];
+                e->origem = u;
+                e->destino = v;
+                e->tipo = a->tipo;
+            }
+        }
+    }
+
+    // Terminais repetidos não viram região própria (fonte aponta para a primeira ocorrência)
+    int regioes = 0;
+    for (int k = 0; k < num_terminais; k++) {
+        pai[k] = k;
+        if (fonte[terminais[k]] == k) regioes++;
+    }
+
+    for (int k = 0; k < num_ligacoes && regioes > 1; k++) {
+        int u = ligacoes[k].origem;
+        int v = ligacoes[k].destino;
+        if (!uniao_unir(pai, posto, fonte[u], fonte[v])) continue;
+        regioes--;
+
+        arestas[(*num_arestas)++] = ligacoes[k];
+        if (peso_total) *peso_total += obter_peso_conexao(ligacoes[k].tipo);
+
+        // Caminhos de u e v até os terminais das suas regiões; caminhos já incluídos por
+        // outra ligação compartilham o trecho final e param no primeiro vértice marcado
+        int extremos[2] = { u, v };
+        for (int e = 0; e < 2; e++) {
+            for (int x = extremos[e]; anterior[x] != -1 && !na_arvore[x]; x = anterior[x]) {
+                na_arvore[x] = 1;
+                ArestaArvore* nova = &arestas[(*num_arestas)++];
+                nova->origem = anterior[x];
+                nova->destino = x;
+                nova->tipo = tipo_conexao_entre(g, x, anterior[x]);
+                if (peso_total) *peso_total += obter_peso_conexao(nova->tipo);
+            }
+        }
+    }
+
+    conectado = (regioes == 1);
+
+fim:
+    free(distancia);
+    free(anterior);
+    free(fonte);
+    free(na_arvore);
+    free(pai);
+    free(posto);
+    free(contagem);
+    free(ligacoes);
+    return conectado;
+}
+
+// Gera o diagrama Mermaid de uma árvore de distribuição, no mesmo formato de gerar_mermaid
+// (apenas os dispositivos que fazem parte da árvore)
+void gerar_mermaid_arvore(Grafo* g, const ArestaArvore* arestas, int num_arestas, FILE* arquivo) {
+    if (!g || !arquivo || (num_arestas > 0 && !arestas)) return;
+
+    char* presente = (char*)calloc(g->num_vertices + 1, sizeof(char));
+
+    fprintf(arquivo, "graph TD\n");
+
+    for (int k = 0; k < num_arestas && presente; k++) {
+        presente[arestas[k].origem] = 1;
+        presente[arestas[k].destino] = 1;
+    }
+    for (int i = 0; i < g->num_vertices; i++) {
+        if (!presente || presente[i]) {
+            fprintf(arquivo, "    %d[\"%s\"]\n", i, g->vertices[i].nome);
+        }
+    }
+
+    for (int k = 0; k < num_arestas; k++) {
+        fprintf(arquivo, "    %d -- %s --- %d\n",
+                arestas[k].origem, tipo_conexao_str(arestas[k].tipo), arestas[k].destino);
+    }
+
+    free(presente);
+}
+
+
+// ===== Histórico de versões da topologia (cópia na escrita) =====
+
+// Cada versão é uma árvore de 32 ramos indexada pela posição do dispositivo; as folhas
+// apontam para registros imutáveis (tipo, nome e lista de conexões). Uma alteração copia
+// apenas o caminho da raiz até os registros alterados e reaproveita o resto da versão
+// anterior; as listas de conexões também são compartilhadas (inserção no início, como em
+// adicionar_aresta, e remoção copiando só o trecho antes do item removido).
+// Dispositivos removidos deixam a posição vazia; o contador de ativos de cada nó converte
+// posições nos IDs compactados que o Grafo usaria na mesma versão.
+
+#define HISTORICO_BITS 5
+#define HISTORICO_RAMOS (1 << HISTORICO_BITS)
+#define HISTORICO_BLOCO (1 << 20)
+
+typedef struct ArcoHistorico {
+    int destino;  // posição do vizinho
+    TipoConexao tipo;
+    int capacidade;
+    const struct ArcoHistorico* proximo;
+} ArcoHistorico;
+
+typedef struct {
+    int versao;   // versão que criou o registro (só ela pode alterá-lo)
+    TipoDispositivo tipo;
+    char nome[50];
+    const ArcoHistorico* arcos;
+} RegistroHistorico;
+
+typedef struct NoHistorico {
+    int versao;
+    int ativos;   // dispositivos presentes na subárvore
+    void* filhos[HISTORICO_RAMOS]; // nós internos ou, no último nível, registros
+} NoHistorico;
+
+typedef struct {
+    long long instante;
+    int num_posicoes;
+    int altura;   // níveis abaixo da raiz
+    NoHistorico* raiz;
+    char descricao[64];
+} VersaoHistorico;
+
+// Memória do histórico: blocos grandes preenchidos em sequência e liberados todos juntos
+typedef struct BlocoArena {
+    struct BlocoArena* anterior;
+    size_t usado;
+    size_t tamanho;
+} BlocoArena;
+
+#define ARENA_CABECALHO ((sizeof(BlocoArena) + 15) & ~(size_t)15)
+
+struct HistoricoGrafo {
+    VersaoHistorico* versoes;
+    int num_versoes;
+    int capacidade_versoes;
+    BlocoArena* arena;
+    size_t memoria;
+};
+
+static void* arena_alocar(HistoricoGrafo* h, size_t tamanho) {
+    tamanho = (tamanho + 15) & ~(size_t)15;
+
+    BlocoArena* b = h->arena;
+    if (!b || b->usado + tamanho > b->tamanho) {
+        size_t capacidade = tamanho > HISTORICO_BLOCO ? tamanho : HISTORICO_BLOCO;
+        b = (BlocoArena*)malloc(ARENA_CABECALHO + capacidade);
+        if (!b) return NULL;
+        b->anterior = h->arena;
+        b->usado = 0;
+        b->tamanho = capacidade;
+        h->arena = b;
+    }
+
+    void* p = (char*)b + ARENA_CABECALHO + b->usado;
+    b->usado += tamanho;
+    h->memoria += tamanho;
+    return p;
+}
+
+static NoHistorico* no_historico_novo(HistoricoGrafo* h, int versao) {
+    NoHistorico* no = (NoHistorico*)arena_alocar(h, sizeof(NoHistorico));
+    if (no) {
+        memset(no, 0, sizeof(NoHistorico));
+        no->versao = versao;
+    }
+    return no;
+}
+
+// Registro da posição 'pos' (NULL se vazia ou fora da versão)
+static const RegistroHistorico* registro_versao(const VersaoHistorico* v, int pos) {
+    if (pos < 0 || pos >= v->num_posicoes) return NULL;
+
+    const NoHistorico* no = v->raiz;
+    for (int nivel = v->altura; nivel > 0 && no; nivel--) {
+        no = (const NoHistorico*)no->filhos[(pos >> (nivel * HISTORICO_BITS)) & (HISTORICO_RAMOS - 1)];
+    }
+    return no ? (const RegistroHistorico*)no->filhos[pos & (HISTORICO_RAMOS - 1)] : NULL;
+}
+
+// Posição do dispositivo com o ID compactado 'id' (-1 se não existe)
+static int posicao_do_id(const VersaoHistorico* v, int id) {
+    if (!v->raiz || id < 0 || id >= v->raiz->ativos) return -1;
+
+    const NoHistorico* no = v->raiz;
+    int pos = 0;
+    for (int nivel = v->altura; nivel >= 0; nivel--) {
+        for (int i = 0; i < HISTORICO_RAMOS; i++) {
+            void* filho = no->filhos[i];
+            if (!filho) continue;
+
+            int ativos = nivel > 0 ? ((const NoHistorico*)filho)->ativos : 1;
+            if (id < ativos) {
+                pos = (pos << HISTORICO_BITS) | i;
+                if (nivel > 0) no = (const NoHistorico*)filho;
+                break;
+            }
+            id -= ativos;
+        }
+    }
+    return pos;
+}
+
+// ID compactado do dispositivo na posição 'pos' (quantos ativos existem antes dela)
+static int id_da_posicao(const VersaoHistorico* v, int pos) {
+    const NoHistorico* no = v->raiz;
+    int id = 0;
+    for (int nivel = v->altura; nivel >= 0 && no; nivel--) {
+        int indice = (pos >> (nivel * HISTORICO_BITS)) & (HISTORICO_RAMOS - 1);
+        for (int i = 0; i < indice; i++) {
+            void* filho = no->filhos[i];
+            if (filho) id += nivel > 0 ? ((const NoHistorico*)filho)->ativos : 1;
+        }
+        if (nivel > 0) no = (const NoHistorico*)no->filhos[indice];
+    }
+    return id;
+}
+
+// Folha da posição 'pos' na versão em construção, copiando o caminho desde a raiz (nós
+// já copiados nesta versão são alterados diretamente) e somando 'delta' aos ativos
+static NoHistorico* folha_mutavel(HistoricoGrafo* h, VersaoHistorico* v, int num, int pos, int delta) {
+    // Aumenta a altura quando a posição não cabe na árvore atual
+    while (!v->raiz || (pos >> ((v->altura + 1) * HISTORICO_BITS)) != 0) {
+        NoHistorico* raiz = no_historico_novo(h, num);
+        if (!raiz) return NULL;
+        if (v->raiz) {
+            raiz->filhos[0] = v->raiz;
+            raiz->ativos = v->raiz->ativos;
+            v->altura++;
+        }
+        v->raiz = raiz;
+    }
+
+    NoHistorico** ref = &v->raiz;
+    for (int nivel = v->altura; ; nivel--) {
+        NoHistorico* no = *ref;
+        if (!no) {
+            no = no_historico_novo(h, num);
+            if (!no) return NULL;
+        } else if (no->versao != num) {
+            NoHistorico* copia = (NoHistorico*)arena_alocar(h, sizeof(NoHistorico));
+            if (!copia) return NULL;
+            *copia = *no;
+            copia->versao = num;
+            no = copia;
+        }
+        *ref = no;
+        no->ativos += delta;
+
+        if (nivel == 0) return no;
+        ref = (NoHistorico**)&no->filhos[(pos >> (nivel * HISTORICO_BITS)) & (HISTORICO_RAMOS - 1)];
+    }
+}
+
+// Registro da posição 'pos' que pode ser alterado na versão em construção
+static RegistroHistorico* registro_mutavel(HistoricoGrafo* h, VersaoHistorico* v, int num, int pos) {
+    NoHistorico* folha = folha_mutavel(h, v, num, pos, 0);
+    if (!folha) return NULL;
+
+    RegistroHistorico** ref = (RegistroHistorico**)&folha->filhos[pos & (HISTORICO_RAMOS - 1)];
+    if (*ref && (*ref)->versao != num) {
+        RegistroHistorico* copia = (RegistroHistorico*)arena_alocar(h, sizeof(RegistroHistorico));
+        if (!copia) return NULL;
+        *copia = **ref;
+        copia->versao = num;
+        *ref = copia;
+    }
+    return *ref;
+}
+
+// Insere a conexão no início da lista do registro (o restante é compartilhado)
+static int registro_inserir_arco(HistoricoGrafo* h, RegistroHistorico* r, int destino, TipoConexao tipo, int capacidade) {
+    ArcoHistorico* arco = (ArcoHistorico*)arena_alocar(h, sizeof(ArcoHistorico));
+    if (!arco) return 0;
+    arco->destino = destino;
+    arco->tipo = tipo;
+    arco->capacidade = capacidade;
+    arco->proximo = r->arcos;
+    r->arcos = arco;
+    return 1;
+}
+
+// Remove a conexão para 'destino' copiando apenas os itens anteriores a ela
+static int registro_remover_arco(HistoricoGrafo* h, RegistroHistorico* r, int destino) {
+    const ArcoHistorico* alvo = r->arcos;
+    while (alvo && alvo->destino != destino) alvo = alvo->proximo;
+    if (!alvo) return 0;
+
+    const ArcoHistorico* cabeca = alvo->proximo;
+    ArcoHistorico* ultima = NULL;
+    for (const ArcoHistorico* a = r->arcos; a != alvo; a = a->proximo) {
+        ArcoHistorico* copia = (ArcoHistorico*)arena_alocar(h, sizeof(ArcoHistorico));
+        if (!copia) return -1;
+        *copia = *a;
+        copia->proximo = alvo->proximo;
+        if (ultima) {
+            ultima->proximo = copia;
+        } else {
+            cabeca = copia;
+        }
+        ultima = copia;
+    }
+    r->arcos = cabeca;
+    return 1;
+}
+
+// Troca a capacidade da conexão para 'destino' copiando os itens até ela (inclusive)
+static int registro_alterar_capacidade(HistoricoGrafo* h, RegistroHistorico* r, int destino, int capacidade) {
+    const ArcoHistorico* alvo = r->arcos;
+    while (alvo && alvo->destino != destino) alvo = alvo->proximo;
+    if (!alvo) return 0;
+
+    ArcoHistorico* ultima = NULL;
+    for (const ArcoHistorico* a = r->arcos; a != alvo->proximo; a = a->proximo) {
+        ArcoHistorico* copia = (ArcoHistorico*)arena_alocar(h, sizeof(ArcoHistorico));
+        if (!copia) return -1;
+        *copia = *a;
+        copia->proximo = alvo->proximo;
+        if (ultima) {
+            ultima->proximo = copia;
+        } else {
+            r->arcos = copia;
+        }
+        ultima = copia;
+    }
+    ultima->capacidade = capacidade;
+    return 1;
+}
+
+// Abre uma nova versão a partir da última; retorna seu número ou -1
+static int historico_iniciar_versao(HistoricoGrafo* h, long long instante, const char* descricao) {
+    if (h->num_versoes == h->capacidade_versoes) {
+        int nova_capacidade = h->capacidade_versoes ? h->capacidade_versoes * 2 : 64;
+        VersaoHistorico* versoes = (VersaoHistorico*)realloc(h->versoes, nova_capacidade * sizeof(VersaoHistorico));
+        if (!versoes) return -1;
+        h->versoes = versoes;
+        h->capacidade_versoes = nova_capacidade;
+    }
+
+    int num = h->num_versoes;
+    VersaoHistorico* v = &h->versoes[num];
+    if (num > 0) {
+        *v = h->versoes[num - 1];
+        // O tempo das versões nunca volta (a busca por instante depende disso)
+        if (instante < v->instante) instante = v->instante;
+    } else {
+        memset(v, 0, sizeof(VersaoHistorico));
+    }
+    v->instante = instante;
+    snprintf(v->descricao, sizeof(v->descricao), "%s", descricao);
+
+    h->num_versoes++;
+    return num;
+}
+
+// Registra o estado completo do grafo como uma nova versão (usado na criação do histórico
+// e quando todos os IDs mudam, como após reordenar_vertices). Retorna o número da versão
+int historico_registrar_grafo(HistoricoGrafo* h, long long instante, Grafo* g, const char* descricao) {
+    if (!h || !g) return -1;
+
+    int num = historico_iniciar_versao(h, instante, descricao ? descricao : "estado completo");
+    if (num < 0) return -1;
+
+    VersaoHistorico* v = &h->versoes[num];
+    v->raiz = NULL;
+    v->altura = 0;
+    v->num_posicoes = g->num_vertices;
+
+    for (int i = 0; i < g->num_vertices; i++) {
+        NoHistorico* folha = folha_mutavel(h, v, num, i, 1);
+        RegistroHistorico* r = folha ? (RegistroHistorico*)arena_alocar(h, sizeof(RegistroHistorico)) : NULL;
+        if (!r) {
+            h->num_versoes--;
+            return -1;
+        }
+
+        r->versao = num;
+        r->tipo = g->vertices[i].tipo;
+        memcpy(r->nome, g->vertices[i].nome, sizeof(r->nome));
+        r->arcos = NULL;
+
+        // Mantém a ordem das listas do grafo
+        ArcoHistorico* ultimo = NULL;
+        for (Aresta* a = g->vertices[i].lista_adjacencia; a; a = a->proxima) {
+            ArcoHistorico* arco = (ArcoHistorico*)arena_alocar(h, sizeof(ArcoHistorico));
+            if (!arco) {
+                h->num_versoes--;
+                return -1;
+            }
+            arco->destino = a->destino;
+            arco->tipo = a->tipo;
+            arco->capacidade = a->capacidade;
+            arco->proximo = NULL;
+            if (ultimo) {
+                ultimo->proximo = arco;
+            } else {
+                r->arcos = arco;
+            }
+            ultimo = arco;
+        }
+
+        folha->filhos[i & (HISTORICO_RAMOS - 1)] = r;
+    }
+
+    return num;
+}
+
+// Cria o histórico com o estado atual do grafo como versão 0 ('g' pode ser NULL para
+// começar vazio)
+HistoricoGrafo* criar_historico(Grafo* g, long long instante) {
+    HistoricoGrafo* h = (HistoricoGrafo*)calloc(1, sizeof(HistoricoGrafo));
+    if (!h) return NULL;
+
+    Grafo vazio;
+    memset(&vazio, 0, sizeof(vazio));
+    if (historico_registrar_grafo(h, instante, g ? g : &vazio, "estado inicial") < 0) {
+        destruir_historico(h);
+        return NULL;
+    }
+    return h;
+}
+
+void destruir_historico(HistoricoGrafo* h) {
+    if (!h) return;
+
+    BlocoArena* b = h->arena;
+    while (b) {
+        BlocoArena* anterior = b->anterior;
+        free(b);
+        b = anterior;
+    }
+    free(h->versoes);
+    free(h);
+}
+
+// As alterações abaixo seguem as mesmas regras e a mesma numeração (IDs compactados) das
+// funções do Grafo; cada alteração bem-sucedida cria uma versão. Se faltar memória no
+// meio, a versão incompleta é descartada e a anterior continua intacta
+
+int historico_adicionar_vertice(HistoricoGrafo* h, long long instante, TipoDispositivo tipo, const char* nome) {
+    if (!h || !nome) return -1;
+
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "adicionado %s", nome);
+    int num = historico_iniciar_versao(h, instante, descricao);
+    if (num < 0) return -1;
+
+    VersaoHistorico* v = &h->versoes[num];
+    int pos = v->num_posicoes;
+    NoHistorico* folha = folha_mutavel(h, v, num, pos, 1);
+    RegistroHistorico* r = folha ? (RegistroHistorico*)arena_alocar(h, sizeof(RegistroHistorico)) : NULL;
+    if (!r) {
+        h->num_versoes--;
+        return -1;
+    }
+
+    r->versao = num;
+    r->tipo = tipo;
+    strncpy(r->nome, nome, sizeof(r->nome) - 1);
+    r->nome[sizeof(r->nome) - 1] = '\0';
+    r->arcos = NULL;
+    folha->filhos[pos & (HISTORICO_RAMOS - 1)] = r;
+    v->num_posicoes++;
+
+    return v->raiz->ativos - 1;
+}
+
+int historico_adicionar_aresta(HistoricoGrafo* h, long long instante, int origem, int destino, TipoConexao tipo) {
+    if (!h || origem == destino) return 0;
+
+    VersaoHistorico* atual = &h->versoes[h->num_versoes - 1];
+    int po = posicao_do_id(atual, origem);
+    int pd = posicao_do_id(atual, destino);
+    if (po < 0 || pd < 0) return 0;
+
+    const RegistroHistorico* ro = registro_versao(atual, po);
+    const RegistroHistorico* rd = registro_versao(atual, pd);
+    if (!validar_conexao(ro->tipo, rd->tipo) && !validar_conexao(rd->tipo, ro->tipo)) return 0;
+    for (const ArcoHistorico* a = ro->arcos; a; a = a->proximo) {
+        if (a->destino == pd) return 0;
+    }
+
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "conexão %d-%d (%s)", origem + 1, destino + 1, tipo_conexao_str(tipo));
+    int num = historico_iniciar_versao(h, instante, descricao);
+    if (num < 0) return 0;
+
+    VersaoHistorico* v = &h->versoes[num];
+    RegistroHistorico* mo = registro_mutavel(h, v, num, po);
+    RegistroHistorico* md = registro_mutavel(h, v, num, pd);
+    if (!mo || !md ||
+        !registro_inserir_arco(h, mo, pd, tipo, obter_capacidade_conexao(tipo)) ||
+        !registro_inserir_arco(h, md, po, tipo, obter_capacidade_conexao(tipo))) {
+        h->num_versoes--;
+        return 0;
+    }
+    return 1;
+}
+
+int historico_remover_aresta(HistoricoGrafo* h, long long instante, int origem, int destino) {
+    if (!h || origem == destino) return 0;
+
+    VersaoHistorico* atual = &h->versoes[h->num_versoes - 1];
+    int po = posicao_do_id(atual, origem);
+    int pd = posicao_do_id(atual, destino);
+    if (po < 0 || pd < 0) return 0;
+
+    int existe = 0;
+    for (const ArcoHistorico* a = registro_versao(atual, po)->arcos; a && !existe; a = a->proximo) {
+        existe = (a->destino == pd);
+    }
+    if (!existe) return 0;
+
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "removida conexão %d-%d", origem + 1, destino + 1);
+    int num = historico_iniciar_versao(h, instante, descricao);
+    if (num < 0) return 0;
+
+    VersaoHistorico* v = &h->versoes[num];
+    RegistroHistorico* mo = registro_mutavel(h, v, num, po);
+    RegistroHistorico* md = registro_mutavel(h, v, num, pd);
+    if (!mo || !md ||
+        registro_remover_arco(h, mo, pd) < 0 ||
+        registro_remover_arco(h, md, po) < 0) {
+        h->num_versoes--;
+        return 0;
+    }
+    return 1;
+}
+
+int historico_definir_capacidade(HistoricoGrafo* h, long long instante, int origem, int destino, int capacidade) {
+    if (!h || origem == destino || capacidade <= 0) return 0;
+
+    VersaoHistorico* atual = &h->versoes[h->num_versoes - 1];
+    int po = posicao_do_id(atual, origem);
+    int pd = posicao_do_id(atual, destino);
+    if (po < 0 || pd < 0) return 0;
+
+    int existe = 0;
+    for (const ArcoHistorico* a = registro_versao(atual, po)->arcos; a && !existe; a = a->proximo) {
+        existe = (a->destino == pd);
+    }
+    if (!existe) return 0;
+
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "capacidade %d-%d = %d Mbps", origem + 1, destino + 1, capacidade);
+    int num = historico_iniciar_versao(h, instante, descricao);
+    if (num < 0) return 0;
+
+    VersaoHistorico* v = &h->versoes[num];
+    RegistroHistorico* mo = registro_mutavel(h, v, num, po);
+    RegistroHistorico* md = registro_mutavel(h, v, num, pd);
+    if (!mo || !md ||
+        registro_alterar_capacidade(h, mo, pd, capacidade) < 0 ||
+        registro_alterar_capacidade(h, md, po, capacidade) < 0) {
+        h->num_versoes--;
+        return 0;
+    }
+    return 1;
+}
+
+int historico_remover_vertice(HistoricoGrafo* h, long long instante, int id) {
+    if (!h) return 0;
+
+    VersaoHistorico* atual = &h->versoes[h->num_versoes - 1];
+    int pos = posicao_do_id(atual, id);
+    if (pos < 0) return 0;
+
+    const RegistroHistorico* r = registro_versao(atual, pos);
+
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "removido %s", r->nome);
+    int num = historico_iniciar_versao(h, instante, descricao);
+    if (num < 0) return 0;
+
+    VersaoHistorico* v = &h->versoes[num];
+    for (const ArcoHistorico* a = r->arcos; a; a = a->proximo) {
+        RegistroHistorico* vizinho = registro_mutavel(h, v, num, a->destino);
+        if (!vizinho || registro_remover_arco(h, vizinho, pos) < 0) {
+            h->num_versoes--;
+            return 0;
+        }
+    }
+
+    NoHistorico* folha = folha_mutavel(h, v, num, pos, -1);
+    if (!folha) {
+        h->num_versoes--;
+        return 0;
+    }
+    folha->filhos[pos & (HISTORICO_RAMOS - 1)] = NULL;
+    return 1;
+}
+
+// Acrescenta em uma única versão os dispositivos e conexões de uma carga em lote, com as
+// regras e a numeração de carregar_em_lote (as conexões já usam os IDs dos novos
+// dispositivos). Só os registros alterados são copiados. Retorna o número de conexões
+// inseridas ou -1
+int historico_adicionar_lote(HistoricoGrafo* h, long long instante,
+                             const DispositivoLote* dispositivos, int num_dispositivos,
+                             const ConexaoLote* conexoes, int num_conexoes) {
+    if (!h || num_dispositivos < 0 || num_conexoes < 0 ||
+        (num_dispositivos > 0 && !dispositivos) || (num_conexoes > 0 && !conexoes)) {
+        return -1;
+    }
+
+    const VersaoHistorico* atual = &h->versoes[h->num_versoes - 1];
+    int n_anterior = atual->raiz ? atual->raiz->ativos : 0;
+    int n = n_anterior + num_dispositivos;
+
+    // Posição de cada ID; os novos dispositivos ocupam as posições seguintes às existentes
+    int* posicao = (int*)malloc((n + 1) * sizeof(int));
+    if (!posicao) return -1;
+    for (int i = 0; i < n_anterior; i++) {
+        posicao[i] = posicao_do_id(atual, i);
+    }
+    for (int i = 0; i < num_dispositivos; i++) {
+        posicao[n_anterior + i] = atual->num_posicoes + i;
+    }
+
+    char descricao[64];
+    snprintf(descricao, sizeof(descricao), "carga em lote (%d dispositivos)", num_dispositivos);
+    int num = historico_iniciar_versao(h, instante, descricao);
+    if (num < 0) {
+        free(posicao);
+        return -1;
+    }
+
+    VersaoHistorico* v = &h->versoes[num];
+    int inseridas = 0;
+
+    for (int i = 0; i < num_dispositivos; i++) {
+        int pos = v->num_posicoes;
+        NoHistorico* folha = folha_mutavel(h, v, num, pos, 1);
+        RegistroHistorico* r = folha ? (RegistroHistorico*)arena_alocar(h, sizeof(RegistroHistorico)) : NULL;
+        if (!r) goto erro;
+
+        r->versao = num;
+        r->tipo = dispositivos[i].tipo;
+        strncpy(r->nome, dispositivos[i].nome, sizeof(r->nome) - 1);
+        r->nome[sizeof(r->nome) - 1] = '\0';
+        r->arcos = NULL;
+        folha->filhos[pos & (HISTORICO_RAMOS - 1)] = r;
+        v->num_posicoes++;
+    }
+
+    for (int k = 0; k < num_conexoes; k++) {
+        const ConexaoLote* e = &conexoes[k];
+        if (e->origem < 0 || e->destino < 0 || e->origem >= n || e->destino >= n ||
+            e->origem == e->destino) {
+            continue;
+        }
+
+        int po = posicao[e->origem];
+        int pd = posicao[e->destino];
+        const RegistroHistorico* ro = registro_versao(v, po);
+        const RegistroHistorico* rd = registro_versao(v, pd);
+        if (!validar_conexao(ro->tipo, rd->tipo) && !validar_conexao(rd->tipo, ro->tipo)) continue;
+
+        int existe = 0;
+        for (const ArcoHistorico* a = ro->arcos; a && !existe; a = a->proximo) {
+            existe = (a->destino == pd);
+        }
+        if (existe) continue;
+
+        RegistroHistorico* mo = registro_mutavel(h, v, num, po);
+        RegistroHistorico* md = registro_mutavel(h, v, num, pd);
+        if (!mo || !md ||
+            !registro_inserir_arco(h, mo, pd, e->tipo, obter_capacidade_conexao(e->tipo)) ||
+            !registro_inserir_arco(h, md, po, e->tipo, obter_capacidade_conexao(e->tipo))) {
+            goto erro;
+        }
+        inseridas++;
+    }
+
+    free(posicao);
+    return inseridas;
+
+erro:
+    h->num_versoes--;
+    free(posicao);
+    return -1;
+}
+
+int historico_num_versoes(HistoricoGrafo* h) {
+    return h ? h->num_versoes : 0;
+}
+
+// Última versão registrada até 'instante' (-1 se o instante é anterior ao histórico)
+int historico_versao_em(HistoricoGrafo* h, long long instante) {
+    if (!h) return -1;
+
+    int inicio = 0, fim = h->num_versoes - 1, encontrada = -1;
+    while (inicio <= fim) {
+        int meio = inicio + (fim - inicio) / 2;
+        if (h->versoes[meio].instante <= instante) {
+            encontrada = meio;
+            inicio = meio + 1;
+        } else {
+            fim = meio - 1;
+        }
+    }
+    return encontrada;
+}
+
+// Dados de uma versão; qualquer ponteiro de saída pode ser NULL. Retorna 0 se não existe
+int historico_info_versao(HistoricoGrafo* h, int versao, long long* instante, int* num_vertices, const char** descricao) {
+    if (!h || versao < 0 || versao >= h->num_versoes) return 0;
+
+    const VersaoHistorico* v = &h->versoes[versao];
+    if (instante) *instante = v->instante;
+    if (num_vertices) *num_vertices = v->raiz ? v->raiz->ativos : 0;
+    if (descricao) *descricao = v->descricao;
+    return 1;
+}
+
+// Nome do dispositivo 'id' em uma versão (NULL se não existe)
+const char* historico_nome_dispositivo(HistoricoGrafo* h, int versao, int id) {
+    if (!h || versao < 0 || versao >= h->num_versoes) return NULL;
+
+    const VersaoHistorico* v = &h->versoes[versao];
+    const RegistroHistorico* r = registro_versao(v, posicao_do_id(v, id));
+    return r ? r->nome : NULL;
+}
+
+// Bytes ocupados pelas versões (cresce com o número de alterações, não com versões x rede)
+size_t historico_memoria(HistoricoGrafo* h) {
+    return h ? h->memoria + h->capacidade_versoes * sizeof(VersaoHistorico) : 0;
+}
+
+// Conexões de uma posição de uma versão do histórico
+static void vizinhos_versao(BuscaDial* b, int u, int d) {
+    const VersaoHistorico* v = (const VersaoHistorico*)b->dados;
+    for (const ArcoHistorico* a = registro_versao(v, u)->arcos; a; a = a->proximo) {
+        busca_dial_relaxar(b, u, a->destino, obter_peso_conexao(a->tipo), d);
+    }
+}
+
+// Rota de menor peso em uma versão (Dial sobre as posições, sem materializar o grafo).
+// IDs de entrada e do caminho seguem a numeração daquela versão
+int encontrar_rota_versao(HistoricoGrafo* h, int versao, int origem, int destino,
+                          int* caminho, int* tamanho_caminho, int* peso) {
+    if (!h || !caminho || !tamanho_caminho || versao < 0 || versao >= h->num_versoes) return 0;
+
+    const VersaoHistorico* v = &h->versoes[versao];
+    int po = posicao_do_id(v, origem);
+    int pd = posicao_do_id(v, destino);
+    if (po < 0 || pd < 0 || po == pd) return 0;
+
+    int n = v->num_posicoes;
+    int* distancia = (int*)malloc(n * sizeof(int));
+    int* anterior = (int*)malloc(n * sizeof(int));
+    if (!distancia || !anterior) {
+        free(distancia);
+        free(anterior);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        distancia[i] = -1;
+    }
+
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+
+    BuscaDial busca;
+    busca_dial_iniciar(&busca, &fila, vizinhos_versao, v, distancia, anterior);
+    busca.destino = pd;
+    busca_dial_origem(&busca, po, 0);
+
+    int encontrou = busca_dial_executar(&busca) > 0 && distancia[pd] >= 0;
+    if (encontrou) {
+        int tamanho = montar_caminho(anterior, pd, caminho);
+        for (int i = 0; i < tamanho; i++) {
+            caminho[i] = id_da_posicao(v, caminho[i]);
+        }
+        *tamanho_caminho = tamanho;
+        if (peso) *peso = distancia[pd];
+    }
+
+    fila_dial_liberar(&fila);
+    free(distancia);
+    free(anterior);
+
+    return encontrou;
+}
+
+// Numera as posições ocupadas de uma subárvore em ordem (IDs compactados)
+static void numerar_posicoes(const NoHistorico* no, int nivel, int base, int* id_posicao, int* proximo_id) {
+    for (int i = 0; i < HISTORICO_RAMOS; i++) {
+        if (!no->filhos[i]) continue;
+
+        int pos = (base << HISTORICO_BITS) | i;
+        if (nivel == 0) {
+            id_posicao[pos] = (*proximo_id)++;
+        } else {
+            numerar_posicoes((const NoHistorico*)no->filhos[i], nivel - 1, pos, id_posicao, proximo_id);
+        }
+    }
+}
+
+// Diagrama Mermaid de uma versão, no mesmo formato de gerar_mermaid
+void gerar_mermaid_versao(HistoricoGrafo* h, int versao, FILE* arquivo) {
+    if (!h || !arquivo || versao < 0 || versao >= h->num_versoes) return;
+
+    const VersaoHistorico* v = &h->versoes[versao];
+    int* id_posicao = (int*)malloc((v->num_posicoes + 1) * sizeof(int));
+    if (!id_posicao) return;
+
+    int num_ids = 0;
+    if (v->raiz) numerar_posicoes(v->raiz, v->altura, 0, id_posicao, &num_ids);
+
+    fprintf(arquivo, "graph TD\n");
+
+    for (int p = 0; p < v->num_posicoes; p++) {
+        const RegistroHistorico* r = registro_versao(v, p);
+        if (r) fprintf(arquivo, "    %d[\"%s\"]\n", id_posicao[p], r->nome);
+    }
+
+    for (int p = 0; p < v->num_posicoes; p++) {
+        const RegistroHistorico* r = registro_versao(v, p);
+        if (!r) continue;
+        for (const ArcoHistorico* a = r->arcos; a; a = a->proximo) {
+            if (p < a->destino) {
+                fprintf(arquivo, "    %d -- %s --- %d\n",
+                        id_posicao[p], tipo_conexao_str(a->tipo), id_posicao[a->destino]);
+            }
+        }
+    }
+
+    free(id_posicao);
+}
+
+
+// ===== Diâmetro e excentricidade (limitantes de Takes-Kosters) =====
+
+// A excentricidade de v é a maior menor-distância de v até um dispositivo da sua parte
+// conectada; o diâmetro é a maior excentricidade. Cada busca completa a partir de v
+// (excentricidade e(v), distâncias d) limita as demais:
+//     max(d(v,w), e(v) - d(v,w)) <= e(w) <= e(v) + d(v,w)
+// Assim, poucas buscas bastam para fixar o diâmetro ou todas as excentricidades, em vez
+// de uma busca por dispositivo.
+
+#define EXCENTRICIDADE_INFINITA 0x3fffffff
+
+// Distâncias (peso ou saltos) de 'origem' até sua parte conectada. 'distancia' deve chegar
+// com -1 em todas as posições; os vértices alcançados ficam em 'visitados' (na ordem em
+// que foram fixados) para que o chamador restaure -1 depois. Retorna quantos foram
+// alcançados (0 em caso de erro)
+static int busca_componente(Grafo* g, int origem, int por_saltos, int* distancia, int* visitados, FilaDial* fila) {
+    if (por_saltos) {
+        // Busca em largura: 'visitados' também serve de fila
+        int alcancados = 0;
+        distancia[origem] = 0;
+        visitados[alcancados++] = origem;
+        for (int k = 0; k < alcancados; k++) {
+            int u = visitados[k];
+            for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+                if (distancia[a->destino] < 0) {
+                    distancia[a->destino] = distancia[u] + 1;
+                    visitados[alcancados++] = a->destino;
+                }
+            }
+        }
+        return alcancados;
+    }
+
+    BuscaDial busca;
+    busca_dial_iniciar(&busca, fila, vizinhos_grafo, g, distancia, NULL);
+    busca.fixados = visitados;
+    busca_dial_origem(&busca, origem, 0);
+    return busca_dial_executar(&busca);
+}
+
+// Núcleo comum: com 'excentricidade' == NULL para assim que o diâmetro é conhecido; caso
+// contrário continua até fixar a excentricidade de todos os vértices
+static int limitar_excentricidades(Grafo* g, int por_saltos, int* excentricidade, ResultadoDiametro* resultado) {
+    int n = g->num_vertices;
+
+    int* distancia = (int*)malloc(n * sizeof(int));
+    int* visitados = (int*)malloc(n * sizeof(int));
+    int* componente = (int*)malloc(n * sizeof(int));
+    int* inferior = (int*)malloc(n * sizeof(int));
+    int* superior = (int*)malloc(n * sizeof(int));
+    int* grau = (int*)calloc(n, sizeof(int));
+    int* ativos = (int*)malloc(n * sizeof(int));
+    char* buscado = (char*)calloc(n, sizeof(char));
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+    int ok = 0;
+
+    if (!distancia || !visitados || !componente || !inferior || !superior || !grau || !ativos || !buscado) goto fim;
+
+    for (int i = 0; i < n; i++) {
+        distancia[i] = -1;
+        componente[i] = -1;
+        for (Aresta* a = g->vertices[i].lista_adjacencia; a; a = a->proxima) grau[i]++;
+    }
+
+    resultado->diametro = 0;
+    resultado->origem = n > 0 ? 0 : -1;
+    resultado->destino = n > 0 ? 0 : -1;
+    resultado->buscas = 0;
+
+    for (int inicio = 0; inicio < n; inicio++) {
+        if (componente[inicio] >= 0) continue;
+
+        // Descobre a parte conectada e inicializa os limitantes dos seus vértices
+        int tamanho = busca_componente(g, inicio, 1, distancia, visitados, &fila);
+        int semente = inicio;
+        for (int k = 0; k < tamanho; k++) {
+            int v = visitados[k];
+            distancia[v] = -1;
+            componente[v] = inicio;
+            inferior[v] = 0;
+            superior[v] = EXCENTRICIDADE_INFINITA;
+            ativos[k] = v;
+
+            // Começa pelo switch de maior grau (costuma ser o centro da rede)
+            int melhor_tipo = g->vertices[semente].tipo == SWITCH;
+            int tipo = g->vertices[v].tipo == SWITCH;
+            if (tipo > melhor_tipo || (tipo == melhor_tipo && grau[v] > grau[semente])) semente = v;
+        }
+
+        int num_ativos = tamanho;
+        int diametro = 0, par_origem = inicio, par_destino = inicio;
+        int escolha = semente;
+
+        for (int iteracao = 0; escolha >= 0; iteracao++) {
+            int alcancados = busca_componente(g, escolha, por_saltos, distancia, visitados, &fila);
+            if (alcancados == 0) goto fim;
+            resultado->buscas++;
+            buscado[escolha] = 1;
+
+            int exc = 0, mais_distante = escolha;
+            for (int k = 0; k < alcancados; k++) {
+                if (distancia[visitados[k]] > exc) {
+                    exc = distancia[visitados[k]];
+                    mais_distante = visitados[k];
+                }
+            }
+            if (exc > diametro) {
+                diametro = exc;
+                par_origem = escolha;
+                par_destino = mais_distante;
+            }
+
+            // Atualiza os limitantes; o maior superior também limita o diâmetro
+            int diametro_superior = 0;
+            for (int k = 0; k < alcancados; k++) {
+                int w = visitados[k];
+                int d = distancia[w];
+                int limite_inferior = d > exc - d ? d : exc - d;
+                if (limite_inferior > inferior[w]) inferior[w] = limite_inferior;
+                if (exc + d < superior[w]) superior[w] = exc + d;
+                if (w == escolha) inferior[w] = superior[w] = exc;
+                if (superior[w] > diametro_superior) diametro_superior = superior[w];
+                distancia[w] = -1;
+            }
+
+            // Para o diâmetro basta que os limitantes se encontrem
+            if (!excentricidade && diametro >= diametro_superior) break;
+
+            // Descarta os vértices com excentricidade já fixada e escolhe a próxima busca:
+            // alterna entre o maior limitante superior (candidato a extremo) e o menor
+            // inferior (central, aperta os limitantes de muitos vértices de uma vez); empates
+            // vão para o de maior grau. Vértices centrais continuam candidatos mesmo quando
+            // não podem superar o diâmetro, porque são eles que baixam o limitante superior
+            int proximo = -1;
+            for (int k = 0; k < num_ativos; k++) {
+                int w = ativos[k];
+                int resolvido = inferior[w] == superior[w];
+                if (resolvido) {
+                    ativos[k--] = ativos[--num_ativos];
+                    continue;
+                }
+                if (buscado[w]) continue;
+
+                if (proximo < 0) {
+                    proximo = w;
+                } else if (iteracao % 2 == 0) {
+                    if (superior[w] > superior[proximo] ||
+                        (superior[w] == superior[proximo] && grau[w] > grau[proximo])) proximo = w;
+                } else {
+                    if (inferior[w] < inferior[proximo] ||
+                        (inferior[w] == inferior[proximo] && grau[w] > grau[proximo])) proximo = w;
+                }
+            }
+            escolha = proximo;
+        }
+
+        if (diametro > resultado->diametro) {
+            resultado->diametro = diametro;
+            resultado->origem = par_origem;
+            resultado->destino = par_destino;
+        }
+    }
+
+    if (excentricidade) {
+        for (int i = 0; i < n; i++) {
+            excentricidade[i] = inferior[i];
+        }
+    }
+    ok = 1;
+
+fim:
+    fila_dial_liberar(&fila);
+    free(distancia);
+    free(visitados);
+    free(componente);
+    free(inferior);
+    free(superior);
+    free(grau);
+    free(ativos);
+    free(buscado);
+    return ok;
+}
+
+// Diâmetro da rede por peso (por_saltos = 0) ou por número de saltos (por_saltos = 1), com
+// o par de dispositivos mais distantes. Redes desconexas: maior diâmetro entre as partes.
+// Retorna 1 em caso de sucesso
+int calcular_diametro(Grafo* g, int por_saltos, ResultadoDiametro* resultado) {
+    if (!g || !resultado) return 0;
+    return limitar_excentricidades(g, por_saltos, NULL, resultado);
+}
+
+// Excentricidade exata de cada dispositivo (pior rota a partir dele, dentro da sua parte
+// conectada); 'resultado' (pode ser NULL) recebe também o diâmetro. Retorna 1 em caso de
+// sucesso
+int calcular_excentricidades(Grafo* g, int por_saltos, int* excentricidade, ResultadoDiametro* resultado) {
+    if (!g || !excentricidade) return 0;
+
+    ResultadoDiametro local;
+    return limitar_excentricidades(g, por_saltos, excentricidade, resultado ? resultado : &local);
+}
+
+
+// ===== Carga em lote paralela =====
+
+// As conexões são divididas em blocos (um por thread) e os vértices em faixas contíguas
+// (uma por thread). Em cada fase todas as threads trabalham sem trava:
+//   1. cada thread valida o seu bloco de conexões e conta quantos arcos vão para cada faixa
+//   2. cada thread copia os arcos do seu bloco (nos dois sentidos) para a área de cada
+//      faixa, em posições reservadas pela contagem, mantendo a ordem das conexões
+//   3. cada thread monta as listas da sua faixa: descarta repetidas e insere os arcos
+// Os nós Aresta continuam alocados um a um com malloc (remover_aresta e destruir_grafo
+// liberam cada nó); o malloc da glibc usa uma arena por thread, então a fase 3 não disputa
+// o alocador.
+
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+} ArcoLote;
+
+// Destino visto por um vértice na fase 3: posição do arco na faixa, ou -1 se a conexão
+// já existia no grafo
+typedef struct {
+    int destino;
+    int posicao;
+} DestinoLote;
+
+static int comparar_destino_lote(const void* a, const void* b) {
+    const DestinoLote* x = (const DestinoLote*)a;
+    const DestinoLote* y = (const DestinoLote*)b;
+    if (x->destino != y->destino) return x->destino < y->destino ? -1 : 1;
+    return x->posicao < y->posicao ? -1 : x->posicao > y->posicao;
+}
+
+typedef struct {
+    Grafo* g;
+    const ConexaoLote* conexoes;
+    int num_conexoes;
+    int num_threads;
+    int tamanho_faixa;
+    char* valida;         // conexão passou na validação da fase 1
+    int* contagem;        // [bloco][faixa]: arcos do bloco para a faixa (depois, posição)
+    ArcoLote* arcos;      // arcos agrupados por faixa
+    int* inicio_faixa;    // início da área de cada faixa em 'arcos' (num_threads + 1)
+    Aresta** cabeca_antiga; // listas antes da carga (para desfazer em caso de erro)
+} CargaLote;
+
+typedef struct {
+    CargaLote* carga;
+    int indice;
+    int fase;
+    int aceitas;
+    int erro;
+} TrabalhoCarga;
+
+static void carga_validar(CargaLote* c, int indice) {
+    int bloco = (c->num_conexoes + c->num_threads - 1) / c->num_threads;
+    int inicio = indice * bloco;
+    int fim = inicio + bloco < c->num_conexoes ? inicio + bloco : c->num_conexoes;
+    int* contagem = &c->contagem[indice * c->num_threads];
+    Grafo* g = c->g;
+
+    for (int k = inicio; k < fim; k++) {
+        const ConexaoLote* e = &c->conexoes[k];
+        int ok = e->origem >= 0 && e->destino >= 0 &&
+                 e->origem < g->num_vertices && e->destino < g->num_vertices &&
+                 e->origem != e->destino &&
+                 (validar_conexao(g->vertices[e->origem].tipo, g->vertices[e->destino].tipo) ||
+                  validar_conexao(g->vertices[e->destino].tipo, g->vertices[e->origem].tipo));
+        c->valida[k] = (char)ok;
+        if (ok) {
+            contagem[e->origem / c->tamanho_faixa]++;
+            contagem[e->destino / c->tamanho_faixa]++;
+        }
+    }
+}
+
+static void carga_distribuir(CargaLote* c, int indice) {
+    int bloco = (c->num_conexoes + c->num_threads - 1) / c->num_threads;
+    int inicio = indice * bloco;
+    int fim = inicio + bloco < c->num_conexoes ? inicio + bloco : c->num_conexoes;
+    int* posicao = &c->contagem[indice * c->num_threads];
+
+    for (int k = inicio; k < fim; k++) {
+        if (!c->valida[k]) continue;
+        const ConexaoLote* e = &c->conexoes[k];
+
+        ArcoLote* ida = &c->arcos[posicao[e->origem / c->tamanho_faixa]++];
+        ida->origem = e->origem;
+        ida->destino = e->destino;
+        ida->tipo = e->tipo;
+
+        ArcoLote* volta = &c->arcos[posicao[e->destino / c->tamanho_faixa]++];
+        volta->origem = e->destino;
+        volta->destino = e->origem;
+        volta->tipo = e->tipo;
+    }
+}
+
+// Monta as listas da faixa. Uma conexão é descartada se já existe no grafo ou se outra
+// anterior da carga liga o mesmo par; as duas faixas envolvidas veem os mesmos arcos na
+// mesma ordem, então tomam a mesma decisão sem se comunicar. As repetidas são achadas
+// ordenando os destinos de cada vértice, então a memória de cada thread é proporcional
+// aos arcos da sua faixa, e não ao número de dispositivos
+static int carga_montar(CargaLote* c, int indice, int* aceitas) {
+    Grafo* g = c->g;
+    int n = g->num_vertices;
+    int primeiro = indice * c->tamanho_faixa;
+    int ultimo = primeiro + c->tamanho_faixa < n ? primeiro + c->tamanho_faixa : n;
+    if (primeiro >= ultimo) return 1;
+
+    int inicio = c->inicio_faixa[indice];
+    int fim = c->inicio_faixa[indice + 1];
+    int num_arcos = fim - inicio;
+    int faixa = ultimo - primeiro;
+
+    // Ordenação estável por origem dentro da faixa (preserva a ordem das conexões)
+    int* comeco = (int*)calloc(faixa + 1, sizeof(int));
+    ArcoLote* ordenados = (ArcoLote*)malloc((num_arcos + 1) * sizeof(ArcoLote));
+    char* repetida = (char*)calloc(num_arcos + 1, sizeof(char));
+    DestinoLote* destinos = NULL;
+    int capacidade_destinos = 0;
+    int ok = 0;
+
+    if (!comeco || !ordenados || !repetida) goto fim;
+
+    for (int k = inicio; k < fim; k++) {
+        comeco[c->arcos[k].origem - primeiro + 1]++;
+    }
+    for (int v = 0; v < faixa; v++) {
+        comeco[v + 1] += comeco[v];
+    }
+    for (int k = inicio; k < fim; k++) {
+        ordenados[comeco[c->arcos[k].origem - primeiro]++] = c->arcos[k];
+    }
+    // Após o preenchimento, comeco[v] aponta para o fim dos arcos de v (= início de v + 1)
+
+    for (int v = primeiro; v < ultimo; v++) {
+        int de = v > primeiro ? comeco[v - primeiro - 1] : 0;
+        int ate = comeco[v - primeiro];
+        if (de == ate) continue;
+
+        // Destinos já ligados a v (posição -1) e os da carga; após a ordenação, só o
+        // primeiro de cada destino vale
+        int m = ate - de;
+        for (Aresta* a = g->vertices[v].lista_adjacencia; a; a = a->proxima) m++;
+        if (m > capacidade_destinos) {
+            DestinoLote* maior = (DestinoLote*)realloc(destinos, m * sizeof(DestinoLote));
+            if (!maior) goto fim;
+            destinos = maior;
+            capacidade_destinos = m;
+        }
+
+        m = 0;
+        for (Aresta* a = g->vertices[v].lista_adjacencia; a; a = a->proxima) {
+            destinos[m].destino = a->destino;
+            destinos[m].posicao = -1;
+            m++;
+        }
+        for (int k = de; k < ate; k++) {
+            destinos[m].destino = ordenados[k].destino;
+            destinos[m].posicao = k;
+            m++;
+        }
+        qsort(destinos, m, sizeof(DestinoLote), comparar_destino_lote);
+        for (int i = 1; i < m; i++) {
+            if (destinos[i].destino == destinos[i - 1].destino) repetida[destinos[i].posicao] = 1;
+        }
+
+        for (int k = de; k < ate; k++) {
+            if (repetida[k]) continue;
+            int destino = ordenados[k].destino;
+
+            Aresta* nova = (Aresta*)malloc(sizeof(Aresta));
+            if (!nova) goto fim;
+            nova->destino = destino;
+            nova->tipo = ordenados[k].tipo;
+            nova->capacidade = obter_capacidade_conexao(ordenados[k].tipo);
+            nova->proxima = g->vertices[v].lista_adjacencia;
+            g->vertices[v].lista_adjacencia = nova;
+
+            if (v < destino) (*aceitas)++;
+        }
+    }
+    ok = 1;
+
+fim:
+    free(comeco);
+    free(ordenados);
+    free(repetida);
+    free(destinos);
+    return ok;
+}
+
+static void* thread_carga(void* arg) {
+    TrabalhoCarga* t = (TrabalhoCarga*)arg;
+
+    if (t->fase == 1) {
+        carga_validar(t->carga, t->indice);
+    } else if (t->fase == 2) {
+        carga_distribuir(t->carga, t->indice);
+    } else {
+        t->erro = !carga_montar(t->carga, t->indice, &t->aceitas);
+    }
+    return NULL;
+}
+
+// Executa uma fase em todas as threads (as que não puderem ser criadas rodam na atual)
+static void carga_executar_fase(TrabalhoCarga* trabalhos, pthread_t* threads, int num_threads, int fase) {
+    int* criada = (int*)calloc(num_threads, sizeof(int));
+
+    for (int t = 0; t < num_threads; t++) {
+        trabalhos[t].fase = fase;
+        if (criada && t > 0 && pthread_create(&threads[t], NULL, thread_carga, &trabalhos[t]) == 0) {
+            criada[t] = 1;
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (!criada || !criada[t]) thread_carga(&trabalhos[t]);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (criada && criada[t]) pthread_join(threads[t], NULL);
+    }
+
+    free(criada);
+}
+
+// Insere muitos dispositivos e conexões de uma vez. Os dispositivos recebem os IDs
+// num_vertices, num_vertices + 1, ... na ordem do vetor; as conexões usam os IDs do grafo
+// já com os novos dispositivos. As regras são as de adicionar_aresta (validar_conexao,
+// sem repetidas) e as listas ficam na mesma ordem que chamadas sucessivas produziriam.
+// A capacidade do grafo é ampliada se necessário. 'rejeitadas' (pode ser NULL) recebe o
+// número de conexões inválidas ou repetidas. Retorna o número de conexões inseridas ou -1
+// em caso de erro (nesse caso o grafo volta ao estado anterior)
+int carregar_em_lote(Grafo* g, const DispositivoLote* dispositivos, int num_dispositivos,
+                     const ConexaoLote* conexoes, int num_conexoes, int num_threads, int* rejeitadas) {
+    if (!g || num_dispositivos < 0 || num_conexoes < 0 ||
+        (num_dispositivos > 0 && !dispositivos) || (num_conexoes > 0 && !conexoes)) {
+        return -1;
+    }
+
+    // Cada conexão vira dois arcos, contados e indexados com int
+    if (num_conexoes > (INT_MAX - 1) / 2 || num_dispositivos > INT_MAX - g->num_vertices) {
+        return -1;
+    }
+
+    int n_anterior = g->num_vertices;
+    int n = n_anterior + num_dispositivos;
+    int externos_anterior = g->num_externos;
+
+    if (g->indice_externo && !reservar_ids_externos(g, num_dispositivos)) return -1;
+    if (n > g->capacidade) {
+        Vertice* vertices = (Vertice*)realloc(g->vertices, n * sizeof(Vertice));
+        if (!vertices) return -1;
+        g->vertices = vertices;
+        g->capacidade = n;
+    }
+
+    for (int i = 0; i < num_dispositivos; i++) {
+        Vertice* v = &g->vertices[n_anterior + i];
+        v->id = n_anterior + i;
+        v->tipo = dispositivos[i].tipo;
+        strncpy(v->nome, dispositivos[i].nome, sizeof(v->nome) - 1);
+        v->nome[sizeof(v->nome) - 1] = '\0';
+        v->lista_adjacencia = NULL;
+    }
+    g->num_vertices = n;
+    anexar_ids_externos(g, n_anterior);
+
+    if (rejeitadas) *rejeitadas = num_conexoes;
+    if (num_conexoes == 0 || n == 0) return 0;
+
+    if (num_threads <= 0) {
+        long processadores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = processadores > 0 ? (int)processadores : 1;
+    }
+    if (num_threads > n) num_threads = n;
+
+    CargaLote carga;
+    memset(&carga, 0, sizeof(carga));
+    carga.g = g;
+    carga.conexoes = conexoes;
+    carga.num_conexoes = num_conexoes;
+    carga.num_threads = num_threads;
+    carga.tamanho_faixa = (n + num_threads - 1) / num_threads;
+    carga.valida = (char*)malloc(num_conexoes * sizeof(char));
+    carga.contagem = (int*)calloc((size_t)num_threads * num_threads, sizeof(int));
+    carga.inicio_faixa = (int*)calloc(num_threads + 1, sizeof(int));
+    carga.cabeca_antiga = (Aresta**)malloc(n * sizeof(Aresta*));
+
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    TrabalhoCarga* trabalhos = (TrabalhoCarga*)calloc(num_threads, sizeof(TrabalhoCarga));
+    int inseridas = -1;
+
+    if (!carga.valida || !carga.contagem || !carga.inicio_faixa || !carga.cabeca_antiga ||
+        !threads || !trabalhos) {
+        goto fim;
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        trabalhos[t].carga = &carga;
+        trabalhos[t].indice = t;
+    }
+
+    carga_executar_fase(trabalhos, threads, num_threads, 1);
+
+    // Converte as contagens em posições: a faixa f recebe primeiro os arcos do bloco 0,
+    // depois os do bloco 1, ... (a ordem das conexões é mantida dentro de cada faixa)
+    long long total = 0;
+    for (int f = 0; f < num_threads; f++) {
+        carga.inicio_faixa[f] = (int)total;
+        for (int b = 0; b < num_threads; b++) {
+            int quantidade = carga.contagem[b * num_threads + f];
+            carga.contagem[b * num_threads + f] = (int)total;
+            total += quantidade;
+        }
+    }
+    if (total > INT_MAX - 1) goto fim;
+    carga.inicio_faixa[num_threads] = (int)total;
+
+    carga.arcos = (ArcoLote*)malloc((total + 1) * sizeof(ArcoLote));
+    if (!carga.arcos) goto fim;
+
+    for (int v = 0; v < n; v++) {
+        carga.cabeca_antiga[v] = g->vertices[v].lista_adjacencia;
+    }
+
+    carga_executar_fase(trabalhos, threads, num_threads, 2);
+    carga_executar_fase(trabalhos, threads, num_threads, 3);
+
+    int erro = 0;
+    inseridas = 0;
+    for (int t = 0; t < num_threads; t++) {
+        if (trabalhos[t].erro) erro = 1;
+        inseridas += trabalhos[t].aceitas;
+    }
+
+    if (erro) {
+        // Desfaz: libera os nós inseridos no início de cada lista
+        for (int v = 0; v < n; v++) {
+            Aresta* atual = g->vertices[v].lista_adjacencia;
+            while (atual != carga.cabeca_antiga[v]) {
+                Aresta* prox = atual->proxima;
+                free(atual);
+                atual = prox;
+            }
+            g->vertices[v].lista_adjacencia = carga.cabeca_antiga[v];
+        }
+        inseridas = -1;
+    } else if (rejeitadas) {
+        *rejeitadas = num_conexoes - inseridas;
+    }
+
+fim:
+    if (inseridas < 0) {
+        g->num_vertices = n_anterior;
+        g->num_externos = externos_anterior;
+    }
+    free(carga.valida);
+    free(carga.contagem);
+    free(carga.inicio_faixa);
+    free(carga.cabeca_antiga);
+    free(carga.arcos);
+    free(threads);
+    free(trabalhos);
+    return inseridas;
+}
+
+
+// ===== Particionamento da rede por site =====
+
+// Um site é um componente conexo sem as conexões de satélite. Os sites são agrupados em
+// no máximo max_particoes partições de tamanho parecido (maior site na partição mais
+// leve); as conexões entre partições são sempre de satélite
+
+typedef struct {
+    int tamanho;
+    int raiz;
+} TamanhoSite;
+
+static int comparar_tamanho_site(const void* a, const void* b) {
+    const TamanhoSite* x = (const TamanhoSite*)a;
+    const TamanhoSite* y = (const TamanhoSite*)b;
+    if (x->tamanho != y->tamanho) return y->tamanho - x->tamanho;
+    return x->raiz - y->raiz;
+}
+
+// Preenche particao[v] (0 a k-1) para cada dispositivo. max_particoes <= 0 deixa um site
+// por partição. Retorna o número k de partições (0 em caso de erro ou rede vazia)
+int particionar_grafo(Grafo* g, int max_particoes, int* particao) {
+    if (!g || !particao || g->num_vertices == 0) return 0;
+
+    int n = g->num_vertices;
+    int* pai = (int*)malloc(n * sizeof(int));
+    int* posto = (int*)calloc(n, sizeof(int));
+    int* tamanho = (int*)calloc(n, sizeof(int));
+    TamanhoSite* sites = (TamanhoSite*)malloc(n * sizeof(TamanhoSite));
+    long long* carga = NULL;
+    int num_particoes = 0;
+
+    if (!pai || !posto || !tamanho || !sites) goto fim;
+
+    for (int v = 0; v < n; v++) {
+        pai[v] = v;
+    }
+    for (int u = 0; u < n; u++) {
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+            if (a->tipo != SATELITE && u < a->destino) {
+                uniao_unir(pai, posto, u, a->destino);
+            }
+        }
+    }
+
+    int num_sites = 0;
+    for (int v = 0; v < n; v++) {
+        tamanho[uniao_encontrar(pai, v)]++;
+    }
+    for (int v = 0; v < n; v++) {
+        if (tamanho[v] > 0) {
+            sites[num_sites].tamanho = tamanho[v];
+            sites[num_sites].raiz = v;
+            num_sites++;
+        }
+    }
+    qsort(sites, num_sites, sizeof(TamanhoSite), comparar_tamanho_site);
+
+    num_particoes = (max_particoes <= 0 || max_particoes > num_sites) ? num_sites : max_particoes;
+    carga = (long long*)calloc(num_particoes, sizeof(long long));
+    if (!carga) {
+        num_particoes = 0;
+        goto fim;
+    }
+
+    // 'tamanho' passa a guardar a partição de cada raiz
+    for (int s = 0; s < num_sites; s++) {
+        int destino = 0;
+        if (s < num_particoes) {
+            destino = s;
+        } else {
+            for (int p = 1; p < num_particoes; p++) {
+                if (carga[p] < carga[destino]) destino = p;
+            }
+        }
+        carga[destino] += sites[s].tamanho;
+        tamanho[sites[s].raiz] = destino;
+    }
+
+    for (int v = 0; v < n; v++) {
+        particao[v] = tamanho[uniao_encontrar(pai, v)];
+    }
+
+fim:
+    free(pai);
+    free(posto);
+    free(tamanho);
+    free(sites);
+    free(carga);
+    return num_particoes;
+}
+
+// Grava uma partição no formato mapeado (ver exportar_grafo_mapeado). 'membros' lista os
+// IDs globais da partição na ordem dos IDs locais e id_local[v] é o ID de v na sua
+// partição; só as conexões internas à partição são gravadas.
+// Retorna 1 em caso de sucesso, 0 em caso de erro
+int exportar_particao_mapeada(Grafo* g, const int* particao, const int* id_local,
+                              const int* membros, int num_membros, const char* caminho) {
+    if (!g || !particao || !id_local || !membros || num_membros <= 0 || !caminho) return 0;
+
+    return gravar_mapeado(g, particao, id_local, membros, num_membros, caminho);
+}
+
+
+// ===== Rotas com restrições =====
+
+// As restrições são aplicadas na própria busca (algoritmo de Dial sobre rótulos): conexões
+// e dispositivos proibidos nunca entram na fila. Com limite de saltos um dispositivo pode
+// precisar de mais de um rótulo (peso, saltos): como os rótulos saem da fila em ordem de
+// peso, um rótulo só é expandido se usar menos saltos que todos os já fixados no mesmo
+// dispositivo. Sem limite, cada dispositivo é fixado uma única vez, como em
+// encontrar_rota_dial
+
+typedef struct {
+    int vertice;
+    int peso;
+    int saltos;
+    int anterior; // índice do rótulo anterior (-1 na origem)
+} RotuloRota;
+
+// Marcas de cada dispositivo na busca restrita
+#define ROTA_EXCLUIDO 1        // não pode aparecer na rota
+#define ROTA_TIPO_PROIBIDO 2   // só pode ser origem ou destino
+
+static int rotulo_inserir(RotuloRota** rotulos, int* num_rotulos, int* capacidade,
+                          int vertice, int peso, int saltos, int anterior) {
+    if (*num_rotulos == *capacidade) {
+        int nova_capacidade = *capacidade ? *capacidade * 2 : 256;
+        RotuloRota* novos = (RotuloRota*)realloc(*rotulos, nova_capacidade * sizeof(RotuloRota));
+        if (!novos) return -1;
+        *rotulos = novos;
+        *capacidade = nova_capacidade;
+    }
+
+    RotuloRota* r = &(*rotulos)[*num_rotulos];
+    r->vertice = vertice;
+    r->peso = peso;
+    r->saltos = saltos;
+    r->anterior = anterior;
+    return (*num_rotulos)++;
+}
+
+// Estado da busca restrita; os itens da fila do Dial são índices de rótulos
+typedef struct {
+    const Grafo* g;
+    FilaDial* fila;
+    unsigned int conexoes;
+    int limite;
+    int destino;
+    const unsigned char* marca;
+    int* distancia;
+    int* saltos_distancia;
+    int* fixado;
+    RotuloRota* rotulos;
+    int num_rotulos;
+    int capacidade;
+    int final;
+} BuscaRestrita;
+
+static int busca_restrita_expandir(void* contexto, int indice, int d) {
+    BuscaRestrita* b = (BuscaRestrita*)contexto;
+    RotuloRota rotulo = b->rotulos[indice];
+    int u = rotulo.vertice;
+
+    // Dominado por um rótulo já fixado (peso menor ou igual e não menos saltos)
+    if (b->fixado[u] >= 0 && (!b->limite || rotulo.saltos >= b->fixado[u])) return 1;
+    b->fixado[u] = rotulo.saltos;
+
+    if (u == b->destino) {
+        b->final = indice;
+        return 0;
+    }
+    if (b->limite && rotulo.saltos >= b->limite) return 1;
+
+    int saltos = rotulo.saltos + 1;
+    for (Aresta* a = b->g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+        int v = a->destino;
+        if (!(b->conexoes & (1u << a->tipo))) continue;
+        if (b->marca[v] && (v != b->destino || (b->marca[v] & ROTA_EXCLUIDO))) continue;
+
+        int peso_aresta = obter_peso_conexao(a->tipo);
+        int novo_peso = d + peso_aresta;
+        if (peso_aresta >= NUM_BALDES) continue;
+
+        if (b->limite) {
+            if (b->fixado[v] >= 0 && saltos >= b->fixado[v]) continue;
+            if (b->distancia[v] >= 0 && novo_peso >= b->distancia[v] && saltos >= b->saltos_distancia[v]) continue;
+        } else if (b->distancia[v] >= 0 && novo_peso >= b->distancia[v]) {
+            continue;
+        }
+
+        if (b->distancia[v] < 0 || novo_peso < b->distancia[v] ||
+            (novo_peso == b->distancia[v] && saltos < b->saltos_distancia[v])) {
+            b->distancia[v] = novo_peso;
+            b->saltos_distancia[v] = saltos;
+        }
+
+        int novo = rotulo_inserir(&b->rotulos, &b->num_rotulos, &b->capacidade, v, novo_peso, saltos, indice);
+        if (novo < 0) {
+            b->fila->erro = 1;
+            return 0;
+        }
+        fila_dial_inserir(b->fila, novo, novo_peso);
+    }
+    return 1;
+}
+
+// Rota de menor peso que respeita as restrições ('restricao' pode ser NULL = nenhuma).
+// Mesma convenção de encontrar_rota_dial; com limite de saltos, é a rota de menor peso
+// entre as que usam no máximo max_saltos conexões. Retorna 1 se encontrou um caminho
+int encontrar_rota_restrita(Grafo* g, int origem, int destino, const RestricaoRota* restricao,
+                            int* caminho, int* tamanho_caminho, int* peso) {
+    if (!g || !caminho || !tamanho_caminho ||
+        origem < 0 || destino < 0 ||
+        origem >= g->num_vertices || destino >= g->num_vertices ||
+        origem == destino) {
+        return 0;
+    }
+
+    int n = g->num_vertices;
+    unsigned int dispositivos = (restricao && restricao->dispositivos) ? restricao->dispositivos : ~0u;
+
+    // distancia/saltos_distancia: melhor rótulo já criado em cada dispositivo (peso e,
+    // no empate, saltos); fixado: menor número de saltos entre os rótulos já expandidos
+    unsigned char* marca = (unsigned char*)calloc(n, sizeof(unsigned char));
+    FilaDial fila;
+    memset(&fila, 0, sizeof(fila));
+
+    BuscaRestrita busca;
+    memset(&busca, 0, sizeof(busca));
+    busca.g = g;
+    busca.fila = &fila;
+    busca.conexoes = (restricao && restricao->conexoes) ? restricao->conexoes : ~0u;
+    busca.limite = (restricao && restricao->max_saltos > 0) ? restricao->max_saltos : 0;
+    busca.destino = destino;
+    busca.marca = marca;
+    busca.distancia = (int*)malloc(n * sizeof(int));
+    busca.saltos_distancia = (int*)malloc(n * sizeof(int));
+    busca.fixado = (int*)malloc(n * sizeof(int));
+    busca.final = -1;
+
+    int encontrou = 0;
+
+    if (!marca || !busca.distancia || !busca.saltos_distancia || !busca.fixado) goto fim;
+
+    for (int v = 0; v < n; v++) {
+        busca.distancia[v] = -1;
+        busca.fixado[v] = -1;
+        if (!(dispositivos & (1u << g->vertices[v].tipo))) marca[v] |= ROTA_TIPO_PROIBIDO;
+    }
+    if (restricao && restricao->excluidos) {
+        for (int i = 0; i < restricao->num_excluidos; i++) {
+            int v = restricao->excluidos[i];
+            if (v >= 0 && v < n) marca[v] |= ROTA_EXCLUIDO;
+        }
+    }
+    if ((marca[origem] & ROTA_EXCLUIDO) || (marca[destino] & ROTA_EXCLUIDO)) goto fim;
+
+    if (rotulo_inserir(&busca.rotulos, &busca.num_rotulos, &busca.capacidade, origem, 0, 0, -1) < 0) goto fim;
+    busca.distancia[origem] = 0;
+    busca.saltos_distancia[origem] = 0;
+    fila_dial_inserir(&fila, 0, 0);
+
+    encontrou = fila_dial_executar(&fila, busca_restrita_expandir, &busca) && busca.final >= 0;
+    if (encontrou) {
+        const RotuloRota* rotulos = busca.rotulos;
+        int tamanho = rotulos[busca.final].saltos + 1;
+        int pos = tamanho - 1;
+        for (int i = busca.final; i != -1; i = rotulos[i].anterior) {
+            caminho[pos--] = rotulos[i].vertice;
+        }
+        *tamanho_caminho = tamanho;
+        if (peso) *peso = rotulos[busca.final].peso;
+    }
+
+fim:
+    fila_dial_liberar(&fila);
+    free(marca);
+    free(busca.distancia);
+    free(busca.saltos_distancia);
+    free(busca.fixado);
+    free(busca.rotulos);
+    return encontrou;
 }
@@ -14,7 +14,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <locale.h>
+#include <time.h>
 
 // Tipos de dispositivo
 typedef enum {
@@ -36,6 +38,7 @@ typedef enum {
 typedef struct Aresta {
     int destino;
     TipoConexao tipo;
+    int capacidade; // Capacidade do enlace em Mbps
     struct Aresta* proxima;
 } Aresta;
 
@@ -52,8 +55,117 @@ typedef struct {
     Vertice* vertices;
     int num_vertices;
     int capacidade;
+    // Tradução de IDs externos, criada na primeira reordenação (antes dela, ID externo =
+    // índice). Um dispositivo novo recebe o próximo ID externo
+    int* id_externo;       // índice -> ID externo
+    int* indice_externo;   // ID externo -> índice atual (-1 = removido)
+    int num_externos;
+    int capacidade_externos;
 } Grafo;
 
+// Fluxo de tráfego entre dois dispositivos (entrada da simulação)
+typedef struct {
+    int origem;
+    int destino;
+    double taxa;     // Mbps
+    double inicio;   // segundos
+    double duracao;  // segundos
+} FluxoTrafego;
+
+// Resumo de uma simulação de tráfego
+typedef struct {
+    long long eventos_processados;
+    int fluxos_roteados;
+    int fluxos_sem_rota;
+    double tempo_simulado;      // segundos
+    double latencia_media_ms;   // latência média dos fluxos no momento em que iniciam
+    double latencia_maxima_ms;
+} ResultadoSimulacao;
+
+// Uso de um enlace (um sentido de uma conexão) ao longo da simulação
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+    int capacidade;
+    double utilizacao_media;    // fração da capacidade (média no tempo)
+    double utilizacao_pico;
+    double atraso_fila_medio_ms;
+    double tempo_saturado;      // segundos com carga >= capacidade
+} UsoEnlace;
+
+// Critério de reordenação dos vértices (melhora a localidade das listas de adjacência)
+typedef enum {
+    REORDENAR_RCM,        // Reverse Cuthill-McKee
+    REORDENAR_HIERARQUIA  // Switch, depois seus servidores, access points e computadores
+} CriterioReordenacao;
+
+// Conexão de uma árvore de distribuição (árvore geradora ou de Steiner)
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+} ArestaArvore;
+
+// Histórico de versões da topologia (estrutura interna definida em grafo.c)
+typedef struct HistoricoGrafo HistoricoGrafo;
+
+// Resultado da análise de diâmetro
+typedef struct {
+    int diametro;   // maior menor-distância entre dois dispositivos conectados
+    int origem;     // par de dispositivos que realiza o diâmetro
+    int destino;
+    int buscas;     // buscas completas executadas (uma por dispositivo sem os limitantes)
+} ResultadoDiametro;
+
+// Dispositivo e conexão para carga em lote (carregar_em_lote)
+typedef struct {
+    TipoDispositivo tipo;
+    char nome[50];
+} DispositivoLote;
+
+typedef struct {
+    int origem;
+    int destino;
+    TipoConexao tipo;
+} ConexaoLote;
+
+// Restrições de uma consulta de rota (encontrar_rota_restrita)
+typedef struct {
+    unsigned int conexoes;      // bit (1 << TipoConexao) de cada conexão permitida; 0 = todas
+    unsigned int dispositivos;  // bit (1 << TipoDispositivo) de cada tipo permitido no meio da rota; 0 = todos
+    int max_saltos;             // número máximo de conexões na rota; <= 0 = sem limite
+    const int* excluidos;       // dispositivos que não podem aparecer na rota
+    int num_excluidos;
+} RestricaoRota;
+
+// Rede dividida em processos por partição (estrutura interna definida em particao.c)
+typedef struct RedeParticionada RedeParticionada;
+
+// Grafo mapeado em arquivo (somente leitura)
+typedef struct {
+    int tipo;
+    int grau;
+    long long primeiro_arco;
+    char nome[50];
+} VerticeMapeado;
+
+typedef struct {
+    int destino;
+    int tipo;
+    int capacidade;
+} ArcoMapeado;
+
+typedef struct {
+    int descritor;
+    void* base;
+    size_t tamanho;
+    int num_vertices;
+    long long num_arcos;
+    const VerticeMapeado* vertices;
+    const ArcoMapeado* arcos;
+} GrafoMapeado;
+
 // Declarações das funções
 Grafo* criar_grafo(int capacidade);
 void destruir_grafo(Grafo* g);
@@ -65,9 +177,69 @@ void gerar_mermaid(Grafo* g, FILE* arquivo);
 const char* tipo_dispositivo_str(TipoDispositivo tipo);
 const char* tipo_conexao_str(TipoConexao tipo);
 int encontrar_rota_mais_rapida(Grafo* g, int origem, int destino, int* caminho, int* tamanho_caminho);
+int encontrar_rota_dial(Grafo* g, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+int encontrar_rota_restrita(Grafo* g, int origem, int destino, const RestricaoRota* restricao, int* caminho, int* tamanho_caminho, int* peso);
 int obter_peso_conexao(TipoConexao tipo);
+int definir_capacidade_aresta(Grafo* g, int origem, int destino, int capacidade);
+int contar_arestas(Grafo* g);
+long long calcular_fluxo_maximo(Grafo* g, const int* origens, int num_origens, const int* destinos, int num_destinos, int* corte, int* tamanho_corte);
+int simular_trafego(Grafo* g, const FluxoTrafego* fluxos, int num_fluxos, ResultadoSimulacao* resultado, UsoEnlace* enlaces);
+int calcular_centralidade(Grafo* g, double* centralidade, int amostras, int num_threads);
+int ranquear_centralidade(Grafo* g, const double* centralidade, TipoDispositivo tipo, int* ids, int max_ids);
+int exportar_grafo_mapeado(Grafo* g, const char* caminho);
+GrafoMapeado* abrir_grafo_mapeado(const char* caminho);
+void fechar_grafo_mapeado(GrafoMapeado* gm);
+void preparar_varredura_mapeado(GrafoMapeado* gm);
+Grafo* importar_grafo_mapeado(GrafoMapeado* gm, int folga);
+int encontrar_rota_mapeado(GrafoMapeado* gm, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void gerar_mermaid_mapeado(GrafoMapeado* gm, FILE* arquivo);
+int reordenar_vertices(Grafo* g, CriterioReordenacao criterio, int* novo_id);
+int renumerar_vertices(Grafo* g, int* novo_id);
+int obter_id_externo(Grafo* g, int indice);
+int resolver_id_externo(Grafo* g, int externo);
+int calcular_arvore_geradora(Grafo* g, ArestaArvore* arestas, int* num_arestas, int* peso_total);
+int calcular_arvore_distribuicao(Grafo* g, const int* terminais, int num_terminais, ArestaArvore* arestas, int* num_arestas, int* peso_total);
+void gerar_mermaid_arvore(Grafo* g, const ArestaArvore* arestas, int num_arestas, FILE* arquivo);
+HistoricoGrafo* criar_historico(Grafo* g, long long instante);
+void destruir_historico(HistoricoGrafo* h);
+int historico_registrar_grafo(HistoricoGrafo* h, long long instante, Grafo* g, const char* descricao);
+int historico_adicionar_vertice(HistoricoGrafo* h, long long instante, TipoDispositivo tipo, const char* nome);
+int historico_adicionar_aresta(HistoricoGrafo* h, long long instante, int origem, int destino, TipoConexao tipo);
+int historico_remover_aresta(HistoricoGrafo* h, long long instante, int origem, int destino);
+int historico_definir_capacidade(HistoricoGrafo* h, long long instante, int origem, int destino, int capacidade);
+int historico_remover_vertice(HistoricoGrafo* h, long long instante, int id);
+int historico_adicionar_lote(HistoricoGrafo* h, long long instante, const DispositivoLote* dispositivos, int num_dispositivos, const ConexaoLote* conexoes, int num_conexoes);
+int historico_num_versoes(HistoricoGrafo* h);
+int historico_versao_em(HistoricoGrafo* h, long long instante);
+int historico_info_versao(HistoricoGrafo* h, int versao, long long* instante, int* num_vertices, const char** descricao);
+const char* historico_nome_dispositivo(HistoricoGrafo* h, int versao, int id);
+size_t historico_memoria(HistoricoGrafo* h);
+int encontrar_rota_versao(HistoricoGrafo* h, int versao, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void gerar_mermaid_versao(HistoricoGrafo* h, int versao, FILE* arquivo);
+int calcular_diametro(Grafo* g, int por_saltos, ResultadoDiametro* resultado);
+int calcular_excentricidades(Grafo* g, int por_saltos, int* excentricidade, ResultadoDiametro* resultado);
+int carregar_em_lote(Grafo* g, const DispositivoLote* dispositivos, int num_dispositivos, const ConexaoLote* conexoes, int num_conexoes, int num_threads, int* rejeitadas);
+int executar_servidor(Grafo* g, const char* endereco, int num_threads);
+int gravar_rede_particionada(Grafo* g, int max_particoes, const char* diretorio);
+RedeParticionada* abrir_rede_particionada(const char* diretorio);
+void encerrar_rede_particionada(RedeParticionada* r);
+int rota_particionada(RedeParticionada* r, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void info_rede_particionada(RedeParticionada* r, int* num_vertices, int* num_particoes, int* num_fronteira, int* maior_particao);
+int executar_particao(const char* caminho, int fd);
 void seed_rede(Grafo* g);
 void exibir_dispositivos(Grafo* g);
+int ler_grupo_dispositivos(Grafo* g, const char* descricao, int* ids);
+int ler_mascara_tipos(const char* descricao, unsigned int* mascara);
+int ler_fluxos_arquivo(const char* caminho, FluxoTrafego** fluxos);
+int ler_carga_arquivo(const char* caminho, DispositivoLote** dispositivos, ConexaoLote** conexoes, int* num_conexoes);
+Grafo* carregar_rede_arquivo(const char* caminho, int folga);
+void exibir_simulacao(Grafo* g, const ResultadoSimulacao* resultado, UsoEnlace* enlaces, int num_enlaces);
+void exibir_dispositivos_mapeado(GrafoMapeado* gm);
+void exibir_informacoes_mapeado(GrafoMapeado* gm);
+void consultar_grafo_mapeado(GrafoMapeado* gm);
+int ler_versao_historico(HistoricoGrafo* h);
+void consultar_historico(HistoricoGrafo* h);
+void consultar_rede_particionada(RedeParticionada* r, Grafo* g, int conferir);
 void exibir_menu();
 
 // Função para popular a rede com dispositivos e conexões de exemplo
@@ -125,6 +297,575 @@ void exibir_dispositivos(Grafo* g) {
     printf("\n");
 }
 
+// Exibe os dispositivos de um grafo mapeado em arquivo
+void exibir_dispositivos_mapeado(GrafoMapeado* gm) {
+    if (!gm || gm->num_vertices == 0) {
+        printf("Nenhum dispositivo cadastrado.\n\n");
+        return;
+    }
+
+    preparar_varredura_mapeado(gm);
+
+    printf("\n=== Dispositivos da Rede (arquivo) ===\n");
+    for (int i = 0; i < gm->num_vertices; i++) {
+        printf("%d - %.*s (%s)\n",
+               i + 1,
+               (int)sizeof(gm->vertices[i].nome), gm->vertices[i].nome,
+               tipo_dispositivo_str((TipoDispositivo)gm->vertices[i].tipo));
+    }
+    printf("\n");
+}
+
+// Exibe as conexões de cada dispositivo de um grafo mapeado em arquivo
+void exibir_informacoes_mapeado(GrafoMapeado* gm) {
+    printf("\n=== Informações da Rede (arquivo) ===\n");
+    printf("Total de dispositivos: %d\n\n", gm->num_vertices);
+
+    preparar_varredura_mapeado(gm);
+
+    for (int i = 0; i < gm->num_vertices; i++) {
+        const VerticeMapeado* v = &gm->vertices[i];
+        printf("%s %d (%.*s):\n",
+               tipo_dispositivo_str((TipoDispositivo)v->tipo),
+               i + 1,
+               (int)sizeof(v->nome), v->nome);
+
+        if (v->primeiro_arco < 0 || v->grau < 0 || v->primeiro_arco > gm->num_arcos ||
+            v->grau > gm->num_arcos - v->primeiro_arco) {
+            printf("  Entrada inválida no arquivo\n\n");
+            continue;
+        }
+
+        for (int k = 0; k < v->grau; k++) {
+            const ArcoMapeado* arco = &gm->arcos[v->primeiro_arco + k];
+            if (arco->destino < 0 || arco->destino >= gm->num_vertices) {
+                printf("  -> Conexão inválida no arquivo\n");
+                continue;
+            }
+            printf("  -> Conectado a %s %d via %s (%d Mbps)\n",
+                   tipo_dispositivo_str((TipoDispositivo)gm->vertices[arco->destino].tipo),
+                   arco->destino + 1,
+                   tipo_conexao_str((TipoConexao)arco->tipo),
+                   arco->capacidade);
+        }
+        printf("  Total de conexões: %d\n\n", v->grau);
+    }
+}
+
+// Submenu de consultas somente leitura sobre um grafo mapeado em arquivo
+void consultar_grafo_mapeado(GrafoMapeado* gm) {
+    int opcao;
+
+    do {
+        printf("\n=== CONSULTA DE ARQUIVO MAPEADO ===\n");
+        printf("1 - Listar dispositivos\n");
+        printf("2 - Exibir informações da rede\n");
+        printf("3 - Calcular rota mais rápida\n");
+        printf("4 - Gerar arquivo Mermaid\n");
+        printf("0 - Voltar\n");
+        printf("Escolha uma opção: ");
+        if (scanf("%d", &opcao) != 1) break;
+
+        switch (opcao) {
+            case 1:
+                exibir_dispositivos_mapeado(gm);
+                break;
+
+            case 2:
+                exibir_informacoes_mapeado(gm);
+                break;
+
+            case 3:
+                {
+                    int origem, destino;
+                    printf("ID do dispositivo origem (1-%d): ", gm->num_vertices);
+                    scanf("%d", &origem);
+                    printf("ID do dispositivo destino (1-%d): ", gm->num_vertices);
+                    scanf("%d", &destino);
+                    origem--;
+                    destino--;
+
+                    int* caminho = (int*)malloc((gm->num_vertices + 1) * sizeof(int));
+                    int tamanho_caminho = 0;
+                    int peso_total = 0;
+
+                    if (!caminho) {
+                        printf("Erro ao alocar memória!\n");
+                        break;
+                    }
+
+                    if (encontrar_rota_mapeado(gm, origem, destino, caminho, &tamanho_caminho, &peso_total)) {
+                        printf("\nCaminho:\n");
+                        for (int i = 0; i < tamanho_caminho; i++) {
+                            printf("  %d. %.*s (%s)\n",
+                                   i + 1,
+                                   (int)sizeof(gm->vertices[caminho[i]].nome),
+                                   gm->vertices[caminho[i]].nome,
+                                   tipo_dispositivo_str((TipoDispositivo)gm->vertices[caminho[i]].tipo));
+                        }
+                        printf("\nPeso total da rota: %d\n", peso_total);
+                    } else {
+                        printf("Não foi possível encontrar uma rota entre os dispositivos selecionados.\n");
+                    }
+
+                    free(caminho);
+                }
+                break;
+
+            case 4:
+                {
+                    FILE* arquivo = fopen("rede.mmd", "w");
+                    if (arquivo) {
+                        gerar_mermaid_mapeado(gm, arquivo);
+                        fclose(arquivo);
+                        printf("Grafo gerado com sucesso em 'rede.mmd'!\n");
+                    } else {
+                        printf("Erro ao criar arquivo de saída!\n");
+                    }
+                }
+                break;
+
+            case 0:
+                break;
+
+            default:
+                printf("Opção inválida! Tente novamente.\n");
+                break;
+        }
+    } while (opcao != 0);
+}
+
+// Lê uma versão do histórico pelo número ou pela data e hora (AAAA-MM-DD HH:MM[:SS]),
+// caso em que vale a última versão registrada até aquele momento. Retorna -1 se inválida
+int ler_versao_historico(HistoricoGrafo* h) {
+    char entrada[64];
+    printf("Versão (número) ou data e hora (AAAA-MM-DD HH:MM): ");
+    if (scanf(" %63[^\n]", entrada) != 1) return -1;
+
+    struct tm data;
+    memset(&data, 0, sizeof(data));
+    int lidos = sscanf(entrada, "%d-%d-%d %d:%d:%d",
+                       &data.tm_year, &data.tm_mon, &data.tm_mday,
+                       &data.tm_hour, &data.tm_min, &data.tm_sec);
+    if (lidos >= 3) {
+        data.tm_year -= 1900;
+        data.tm_mon -= 1;
+        data.tm_isdst = -1;
+        return historico_versao_em(h, (long long)mktime(&data));
+    }
+
+    int versao = atoi(entrada);
+    return versao >= 0 && versao < historico_num_versoes(h) ? versao : -1;
+}
+
+// Submenu de consultas sobre versões anteriores da topologia
+void consultar_historico(HistoricoGrafo* h) {
+    int num_versoes = historico_num_versoes(h);
+    int primeira = num_versoes > 30 ? num_versoes - 30 : 0;
+
+    printf("\n=== Histórico da Topologia ===\n");
+    printf("%d versões, %.1f KB\n", num_versoes, historico_memoria(h) / 1024.0);
+    if (primeira > 0) {
+        printf("(exibindo as 30 mais recentes)\n");
+    }
+    for (int i = primeira; i < num_versoes; i++) {
+        long long instante;
+        int num_vertices;
+        const char* descricao;
+        historico_info_versao(h, i, &instante, &num_vertices, &descricao);
+
+        time_t t = (time_t)instante;
+        char data[32];
+        strftime(data, sizeof(data), "%Y-%m-%d %H:%M:%S", localtime(&t));
+        printf("%d - %s, %d dispositivos: %s\n", i, data, num_vertices, descricao);
+    }
+
+    int versao = ler_versao_historico(h);
+    if (versao < 0) {
+        printf("Versão inválida ou anterior ao histórico!\n");
+        return;
+    }
+
+    int num_vertices = 0;
+    historico_info_versao(h, versao, NULL, &num_vertices, NULL);
+
+    int opcao;
+    do {
+        printf("\n=== VERSÃO %d ===\n", versao);
+        printf("1 - Calcular rota mais rápida\n");
+        printf("2 - Gerar arquivo Mermaid\n");
+        printf("0 - Voltar\n");
+        printf("Escolha uma opção: ");
+        if (scanf("%d", &opcao) != 1) break;
+
+        switch (opcao) {
+            case 1:
+                {
+                    int origem, destino;
+                    printf("ID do dispositivo origem (1-%d): ", num_vertices);
+                    scanf("%d", &origem);
+                    printf("ID do dispositivo destino (1-%d): ", num_vertices);
+                    scanf("%d", &destino);
+                    origem--;
+                    destino--;
+
+                    int* caminho = (int*)malloc((num_vertices + 1) * sizeof(int));
+                    int tamanho_caminho = 0, peso = 0;
+
+                    if (!caminho) {
+                        printf("Erro ao alocar memória!\n");
+                        break;
+                    }
+
+                    if (encontrar_rota_versao(h, versao, origem, destino, caminho, &tamanho_caminho, &peso)) {
+                        printf("\nCaminho (peso %d):\n", peso);
+                        for (int i = 0; i < tamanho_caminho; i++) {
+                            printf("  %d. %s (%d)\n", i + 1,
+                                   historico_nome_dispositivo(h, versao, caminho[i]), caminho[i] + 1);
+                        }
+                    } else {
+                        printf("Não foi possível encontrar uma rota entre os dispositivos selecionados.\n");
+                    }
+
+                    free(caminho);
+                }
+                break;
+
+            case 2:
+                {
+                    FILE* arquivo = fopen("historico.mmd", "w");
+                    if (arquivo) {
+                        gerar_mermaid_versao(h, versao, arquivo);
+                        fclose(arquivo);
+                        printf("Versão %d gerada em 'historico.mmd'!\n", versao);
+                    } else {
+                        printf("Erro ao criar arquivo de saída!\n");
+                    }
+                }
+                break;
+
+            case 0:
+                break;
+
+            default:
+                printf("Opção inválida! Tente novamente.\n");
+                break;
+        }
+    } while (opcao != 0);
+}
+
+// Submenu de rotas sobre a rede dividida em processos. 'g' (pode ser NULL, quando a
+// divisão foi aberta do diretório) fornece os nomes dos dispositivos; com 'conferir',
+// cada rota é comparada com a busca na rede completa (mesmo peso)
+void consultar_rede_particionada(RedeParticionada* r, Grafo* g, int conferir) {
+    int num_vertices = 0, num_particoes = 0, num_fronteira = 0, maior_particao = 0;
+    info_rede_particionada(r, &num_vertices, &num_particoes, &num_fronteira, &maior_particao);
+
+    printf("\n=== Rede Particionada ===\n");
+    printf("%d partições (um processo cada), maior com %d dispositivos\n",
+           num_particoes, maior_particao);
+    printf("%d dispositivos de fronteira no overlay\n", num_fronteira);
+
+    int opcao;
+    do {
+        printf("\n=== REDE PARTICIONADA ===\n");
+        printf("1 - Calcular rota mais rápida\n");
+        printf("0 - Voltar (encerra os processos)\n");
+        printf("Escolha uma opção: ");
+        if (scanf("%d", &opcao) != 1) break;
+
+        switch (opcao) {
+            case 1:
+                {
+                    int origem, destino;
+                    printf("ID do dispositivo origem (1-%d): ", num_vertices);
+                    scanf("%d", &origem);
+                    printf("ID do dispositivo destino (1-%d): ", num_vertices);
+                    scanf("%d", &destino);
+                    origem--;
+                    destino--;
+
+                    int* caminho = (int*)malloc(num_vertices * sizeof(int));
+                    int tamanho_caminho = 0, peso = 0;
+
+                    if (!caminho) {
+                        printf("Erro ao alocar memória!\n");
+                        break;
+                    }
+
+                    int encontrou = rota_particionada(r, origem, destino, caminho, &tamanho_caminho, &peso);
+                    if (encontrou > 0) {
+                        printf("\nCaminho (peso %d):\n", peso);
+                        for (int i = 0; i < tamanho_caminho; i++) {
+                            if (g) {
+                                printf("  %d. %s (%d)\n", i + 1,
+                                       g->vertices[caminho[i]].nome, caminho[i] + 1);
+                            } else {
+                                printf("  %d. Dispositivo %d\n", i + 1, caminho[i] + 1);
+                            }
+                        }
+
+                        int tamanho_completo = 0, peso_completo = 0;
+                        if (conferir && g &&
+                            encontrar_rota_dial(g, origem, destino, caminho, &tamanho_completo, &peso_completo)) {
+                            printf("Peso na rede completa: %d%s\n", peso_completo,
+                                   peso_completo == peso ? "" : " (DIVERGENTE)");
+                        }
+                    } else if (encontrou < 0) {
+                        printf("Erro ao consultar os processos das partições! Divida a rede novamente.\n");
+                    } else {
+                        printf("Não foi possível encontrar uma rota entre os dispositivos selecionados.\n");
+                    }
+
+                    free(caminho);
+                }
+                break;
+
+            case 0:
+                break;
+
+            default:
+                printf("Opção inválida! Tente novamente.\n");
+                break;
+        }
+    } while (opcao != 0);
+}
+
+// Lê um grupo de dispositivos (IDs informados pelo usuário, começando em 1)
+// Retorna a quantidade lida ou 0 se algum ID for inválido
+int ler_grupo_dispositivos(Grafo* g, const char* descricao, int* ids) {
+    int quantidade;
+    printf("Quantidade de dispositivos de %s: ", descricao);
+    scanf("%d", &quantidade);
+
+    if (quantidade <= 0 || quantidade > g->num_vertices) {
+        printf("Quantidade inválida!\n");
+        return 0;
+    }
+
+    for (int i = 0; i < quantidade; i++) {
+        printf("ID do dispositivo de %s %d (1-%d): ", descricao, i + 1, g->num_vertices);
+        scanf("%d", &ids[i]);
+        ids[i]--;
+
+        if (ids[i] < 0 || ids[i] >= g->num_vertices) {
+            printf("ID inválido!\n");
+            return 0;
+        }
+    }
+
+    return quantidade;
+}
+
+// Lê um conjunto de tipos como uma sequência de códigos de 0 a 3 (ex.: "123").
+// '*' permite todos (máscara 0). Retorna 0 se a entrada tiver algum código inválido
+int ler_mascara_tipos(const char* descricao, unsigned int* mascara) {
+    char codigos[16];
+    printf("%s (códigos sem espaço, * = todos): ", descricao);
+    if (scanf("%15s", codigos) != 1) return 0;
+
+    *mascara = 0;
+    if (strcmp(codigos, "*") == 0) return 1;
+
+    for (int i = 0; codigos[i]; i++) {
+        if (codigos[i] < '0' || codigos[i] > '3') {
+            printf("Código inválido: %c\n", codigos[i]);
+            return 0;
+        }
+        *mascara |= 1u << (codigos[i] - '0');
+    }
+    return 1;
+}
+
+// Lê uma matriz de tráfego de um arquivo texto, uma linha por fluxo:
+//   origem destino taxa_mbps inicio_s duracao_s
+// IDs começam em 1; linhas vazias ou iniciadas com '#' são ignoradas.
+// Retorna a quantidade de fluxos lidos ou -1 em caso de erro
+int ler_fluxos_arquivo(const char* caminho, FluxoTrafego** fluxos) {
+    FILE* arquivo = fopen(caminho, "r");
+    if (!arquivo) return -1;
+
+    int capacidade = 64;
+    int quantidade = 0;
+    FluxoTrafego* lista = (FluxoTrafego*)malloc(capacidade * sizeof(FluxoTrafego));
+    if (!lista) {
+        fclose(arquivo);
+        return -1;
+    }
+
+    char linha[256];
+    while (fgets(linha, sizeof(linha), arquivo)) {
+        FluxoTrafego f;
+        if (linha[0] == '#' ||
+            sscanf(linha, "%d %d %lf %lf %lf",
+                   &f.origem, &f.destino, &f.taxa, &f.inicio, &f.duracao) != 5) {
+            continue;
+        }
+
+        if (quantidade == capacidade) {
+            capacidade *= 2;
+            FluxoTrafego* nova = (FluxoTrafego*)realloc(lista, capacidade * sizeof(FluxoTrafego));
+            if (!nova) {
+                free(lista);
+                fclose(arquivo);
+                return -1;
+            }
+            lista = nova;
+        }
+
+        f.origem--;
+        f.destino--;
+        lista[quantidade++] = f;
+    }
+
+    fclose(arquivo);
+    *fluxos = lista;
+    return quantidade;
+}
+
+// Lê um arquivo de carga em lote, uma linha por item:
+//   D <tipo 0-3> <nome>          (dispositivo)
+//   C <origem> <destino> <tipo>  (conexão; IDs começam em 1 e contam os dispositivos
+//                                 já existentes seguidos dos declarados no arquivo)
+// Linhas vazias ou iniciadas com '#' são ignoradas.
+// Retorna a quantidade de dispositivos lidos ou -1 em caso de erro
+int ler_carga_arquivo(const char* caminho, DispositivoLote** dispositivos, ConexaoLote** conexoes, int* num_conexoes) {
+    FILE* arquivo = fopen(caminho, "r");
+    if (!arquivo) return -1;
+
+    int capacidade_d = 64, capacidade_c = 64;
+    int quantidade_d = 0, quantidade_c = 0;
+    DispositivoLote* lista_d = (DispositivoLote*)malloc(capacidade_d * sizeof(DispositivoLote));
+    ConexaoLote* lista_c = (ConexaoLote*)malloc(capacidade_c * sizeof(ConexaoLote));
+    if (!lista_d || !lista_c) {
+        free(lista_d);
+        free(lista_c);
+        fclose(arquivo);
+        return -1;
+    }
+
+    char linha[256];
+    int erro = 0;
+    while (!erro && fgets(linha, sizeof(linha), arquivo)) {
+        DispositivoLote d;
+        ConexaoLote c;
+        int tipo;
+
+        if (sscanf(linha, " D %d %49[^\r\n]", &tipo, d.nome) == 2 && tipo >= 0 && tipo <= 3) {
+            if (quantidade_d == capacidade_d) {
+                capacidade_d *= 2;
+                DispositivoLote* nova = (DispositivoLote*)realloc(lista_d, capacidade_d * sizeof(DispositivoLote));
+                if (!nova) {
+                    erro = 1;
+                    break;
+                }
+                lista_d = nova;
+            }
+            d.tipo = (TipoDispositivo)tipo;
+            lista_d[quantidade_d++] = d;
+        } else if (sscanf(linha, " C %d %d %d", &c.origem, &c.destino, &tipo) == 3 && tipo >= 0 && tipo <= 3) {
+            if (quantidade_c == capacidade_c) {
+                capacidade_c *= 2;
+                ConexaoLote* nova = (ConexaoLote*)realloc(lista_c, capacidade_c * sizeof(ConexaoLote));
+                if (!nova) {
+                    erro = 1;
+                    break;
+                }
+                lista_c = nova;
+            }
+            c.origem--;
+            c.destino--;
+            c.tipo = (TipoConexao)tipo;
+            lista_c[quantidade_c++] = c;
+        }
+    }
+
+    fclose(arquivo);
+    if (erro) {
+        free(lista_d);
+        free(lista_c);
+        return -1;
+    }
+
+    *dispositivos = lista_d;
+    *conexoes = lista_c;
+    *num_conexoes = quantidade_c;
+    return quantidade_d;
+}
+
+// Carrega uma rede de um arquivo mapeado (opção 14) ou de um arquivo de carga em lote
+// (opção 20). folga = dispositivos que ainda poderão ser adicionados.
+// Retorna NULL se o arquivo não puder ser lido
+Grafo* carregar_rede_arquivo(const char* caminho, int folga) {
+    GrafoMapeado* gm = abrir_grafo_mapeado(caminho);
+    if (gm) {
+        Grafo* g = importar_grafo_mapeado(gm, folga);
+        fechar_grafo_mapeado(gm);
+        return g;
+    }
+
+    DispositivoLote* dispositivos = NULL;
+    ConexaoLote* conexoes = NULL;
+    int num_conexoes = 0;
+    int num_dispositivos = ler_carga_arquivo(caminho, &dispositivos, &conexoes, &num_conexoes);
+    if (num_dispositivos < 0) return NULL;
+
+    // Um arquivo sem nenhuma linha de dispositivo (ex.: mapeado e corrompido) é recusado
+    Grafo* g = NULL;
+    if (num_dispositivos > 0 && num_dispositivos <= INT_MAX - folga) {
+        g = criar_grafo(num_dispositivos + folga);
+    }
+
+    int rejeitadas = 0;
+    if (g && carregar_em_lote(g, dispositivos, num_dispositivos, conexoes, num_conexoes, 0, &rejeitadas) < 0) {
+        destruir_grafo(g);
+        g = NULL;
+    } else if (g && rejeitadas > 0) {
+        printf("Aviso: %d conexões inválidas ou repetidas ignoradas.\n", rejeitadas);
+    }
+
+    free(dispositivos);
+    free(conexoes);
+    return g;
+}
+
+// Exibe o resumo da simulação e os enlaces mais utilizados
+void exibir_simulacao(Grafo* g, const ResultadoSimulacao* resultado, UsoEnlace* enlaces, int num_enlaces) {
+    printf("\n=== Resultado da Simulação ===\n");
+    printf("Eventos processados: %lld\n", resultado->eventos_processados);
+    printf("Fluxos roteados: %d (sem rota: %d)\n",
+           resultado->fluxos_roteados, resultado->fluxos_sem_rota);
+    printf("Tempo simulado: %.3f s\n", resultado->tempo_simulado);
+    printf("Latência de fila média: %.3f ms (máxima: %.3f ms)\n\n",
+           resultado->latencia_media_ms, resultado->latencia_maxima_ms);
+
+    // Seleciona os 10 enlaces com maior utilização média
+    printf("Enlaces mais utilizados:\n");
+    for (int k = 0; k < 10 && k < num_enlaces; k++) {
+        int maior = k;
+        for (int i = k + 1; i < num_enlaces; i++) {
+            if (enlaces[i].utilizacao_media > enlaces[maior].utilizacao_media) {
+                maior = i;
+            }
+        }
+        if (enlaces[maior].utilizacao_pico <= 0) break;
+
+        UsoEnlace temp = enlaces[k];
+        enlaces[k] = enlaces[maior];
+        enlaces[maior] = temp;
+
+        printf("  %s -> %s (%s, %d Mbps): média %.1f%%, pico %.1f%%, fila %.3f ms, saturado %.1f s\n",
+               g->vertices[enlaces[k].origem].nome,
+               g->vertices[enlaces[k].destino].nome,
+               tipo_conexao_str(enlaces[k].tipo),
+               enlaces[k].capacidade,
+               100.0 * enlaces[k].utilizacao_media,
+               100.0 * enlaces[k].utilizacao_pico,
+               enlaces[k].atraso_fila_medio_ms,
+               enlaces[k].tempo_saturado);
+    }
+}
+
 // Exibe o menu principal
 void exibir_menu() {
     printf("\n=== MENU PRINCIPAL ===\n");
@@ -137,13 +878,73 @@ void exibir_menu() {
     printf("7 - Gerar arquivo Mermaid\n");
     printf("8 - Popular rede (seed)\n");
     printf("9 - Calcular rota mais rápida\n");
+    printf("10 - Definir capacidade de conexão\n");
+    printf("11 - Calcular capacidade máxima entre grupos (fluxo máximo)\n");
+    printf("12 - Simular tráfego (arquivo de fluxos)\n");
+    printf("13 - Dispositivos críticos (centralidade de intermediação)\n");
+    printf("14 - Exportar rede para arquivo mapeado\n");
+    printf("15 - Consultar arquivo mapeado (somente leitura)\n");
+    printf("16 - Reordenar dispositivos (localidade)\n");
+    printf("17 - Árvore de distribuição (multicast)\n");
+    printf("18 - Histórico da topologia\n");
+    printf("19 - Diâmetro e excentricidade (pior rota)\n");
+    printf("20 - Carregar dispositivos e conexões de arquivo (em lote)\n");
+    printf("21 - Dividir a rede em processos por site\n");
+    printf("22 - Calcular rota com restrições\n");
     printf("0 - Sair\n");
     printf("Escolha uma opção: ");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+
+    setlocale(LC_ALL, "pt_BR.UTF-8");
+
+    // Modo servidor: rede --servidor <socket|porta> [capacidade] [--seed | <arquivo>]
+    // O arquivo é um grafo mapeado (opção 14) ou uma carga em lote (opção 20); nesse caso
+    // a capacidade é o espaço para dispositivos além dos carregados
+    if (argc >= 3 && strcmp(argv[1], "--servidor") == 0) {
+        int capacidade = 50;
+        int popular = 0;
+        const char* arquivo = NULL;
+        for (int i = 3; i < argc; i++) {
+            char* fim;
+            long valor = strtol(argv[i], &fim, 10);
+            if (strcmp(argv[i], "--seed") == 0) {
+                popular = 1;
+            } else if (*argv[i] != '\0' && *fim == '\0' && valor > 0 && valor <= INT_MAX) {
+                capacidade = (int)valor;
+            } else {
+                arquivo = argv[i];
+            }
+        }
+
+        if (popular && arquivo) {
+            printf("Uso: %s --servidor <socket|porta> [capacidade] [--seed | <arquivo>]\n", argv[0]);
+            return 1;
+        }
+
+        Grafo* g = arquivo ? carregar_rede_arquivo(arquivo, capacidade) : criar_grafo(capacidade);
+        if (!g) {
+            if (arquivo) {
+                printf("Erro ao carregar a rede de '%s'!\n", arquivo);
+            } else {
+                printf("Erro ao criar grafo!\n");
+            }
+            return 1;
+        }
+        if (popular) {
+            seed_rede(g);
+        }
+
+        int status = executar_servidor(g, argv[2], 0);
+        destruir_grafo(g);
+        return status;
+    }
 
-    setlocale(LC_ALL, "pt_BR.UTF-8");
+    // Processo de partição (iniciado pela opção 21): rede --particao <arquivo> <descritor>
+    if (argc >= 4 && strcmp(argv[1], "--particao") == 0) {
+        return executar_particao(argv[2], atoi(argv[3]));
+    }
     // Cria o grafo com capacidade inicial
     Grafo* rede = criar_grafo(50);
     if (!rede) {
@@ -151,6 +952,9 @@ int main() {
         return 1;
     }
 
+    // Histórico das alterações feitas pelo menu (versão 0 = rede vazia)
+    HistoricoGrafo* historico = criar_historico(rede, (long long)time(NULL));
+
     int opcao;
     char nome[50];
     int tipo_disp, tipo_conn;
@@ -183,7 +987,11 @@ int main() {
                 scanf(" %[^\n]", nome);
 
                 id = adicionar_vertice(rede, (TipoDispositivo)tipo_disp, nome);
-                if (id >= 0) {
+                if (id >= 0 && historico_adicionar_vertice(historico, (long long)time(NULL), (TipoDispositivo)tipo_disp, nome) < 0) {
+                    // Desfaz para que a rede e o histórico continuem iguais
+                    remover_vertice(rede, id);
+                    printf("Erro ao registrar no histórico! Dispositivo não adicionado.\n");
+                } else if (id >= 0) {
                     printf("Dispositivo '%s' adicionado com ID %d!\n", nome, id + 1);
                 } else {
                     printf("Erro ao adicionar dispositivo! Capacidade máxima atingida.\n");
@@ -206,7 +1014,10 @@ int main() {
                     char nome_removido[50];
                     strcpy(nome_removido, rede->vertices[id].nome);
 
-                    if (remover_vertice(rede, id)) {
+                    // Registra antes de remover: a remoção não tem como ser desfeita
+                    if (!historico_remover_vertice(historico, (long long)time(NULL), id)) {
+                        printf("Erro ao registrar no histórico! Dispositivo não removido.\n");
+                    } else if (remover_vertice(rede, id)) {
                         printf("Dispositivo '%s' removido com sucesso!\n", nome_removido);
                     } else {
                         printf("Erro ao remover dispositivo!\n");
@@ -253,10 +1064,13 @@ int main() {
                     break;
                 }
 
-                if (adicionar_aresta(rede, origem, destino, (TipoConexao)tipo_conn)) {
-                    printf("Conexão adicionada com sucesso!\n");
-                } else {
+                if (!adicionar_aresta(rede, origem, destino, (TipoConexao)tipo_conn)) {
                     printf("Erro ao adicionar conexão! Verifique se a conexão é válida ou já existe.\n");
+                } else if (!historico_adicionar_aresta(historico, (long long)time(NULL), origem, destino, (TipoConexao)tipo_conn)) {
+                    remover_aresta(rede, origem, destino);
+                    printf("Erro ao registrar no histórico! Conexão não adicionada.\n");
+                } else {
+                    printf("Conexão adicionada com sucesso!\n");
                 }
                 break;
 
@@ -284,10 +1098,21 @@ int main() {
                     break;
                 }
 
-                if (remover_aresta(rede, origem, destino)) {
-                    printf("Conexão removida com sucesso!\n");
-                } else {
-                    printf("Conexão não encontrada!\n");
+                {
+                    int existe = 0;
+                    for (Aresta* a = rede->vertices[origem].lista_adjacencia; a && !existe; a = a->proxima) {
+                        existe = (a->destino == destino);
+                    }
+
+                    // Registra antes de remover, como na remoção de dispositivo
+                    if (!existe) {
+                        printf("Conexão não encontrada!\n");
+                    } else if (!historico_remover_aresta(historico, (long long)time(NULL), origem, destino)) {
+                        printf("Erro ao registrar no histórico! Conexão não removida.\n");
+                    } else {
+                        remover_aresta(rede, origem, destino);
+                        printf("Conexão removida com sucesso!\n");
+                    }
                 }
                 break;
 
@@ -314,10 +1139,11 @@ int main() {
                     int num_conexoes = 0;
                     while (atual) {
                         num_conexoes++;
-                        printf("  -> Conectado a %s %d via %s\n",
+                        printf("  -> Conectado a %s %d via %s (%d Mbps)\n",
                                tipo_dispositivo_str(rede->vertices[atual->destino].tipo),
                                atual->destino + 1,
-                               tipo_conexao_str(atual->tipo));
+                               tipo_conexao_str(atual->tipo),
+                               atual->capacidade);
                         atual = atual->proxima;
                     }
                     printf("  Total de conexões: %d\n\n", num_conexoes);
@@ -352,10 +1178,16 @@ int main() {
                         }
                         // Popular a rede novamente
                         seed_rede(rede);
+                        if (historico_registrar_grafo(historico, (long long)time(NULL), rede, "rede de exemplo") < 0) {
+                            printf("Aviso: a nova rede não foi registrada no histórico.\n");
+                        }
                     }
                 } else {
                     // se não houver dispositivos, popular a rede
                     seed_rede(rede);
+                    if (historico_registrar_grafo(historico, (long long)time(NULL), rede, "rede de exemplo") < 0) {
+                        printf("Aviso: a nova rede não foi registrada no histórico.\n");
+                    }
                 }
                 break;
 
@@ -444,6 +1276,610 @@ int main() {
                 }
                 break;
 
+            case 10: // Definir capacidade de conexão
+                {
+                    printf("\n--- Definir Capacidade de Conexão ---\n");
+                    exibir_dispositivos(rede);
+
+                    if (rede->num_vertices < 2) {
+                        printf("Não há conexões para alterar.\n");
+                        break;
+                    }
+
+                    printf("ID do dispositivo origem (1-%d): ", rede->num_vertices);
+                    scanf("%d", &origem);
+                    origem--;
+
+                    printf("ID do dispositivo destino (1-%d): ", rede->num_vertices);
+                    scanf("%d", &destino);
+                    destino--;
+
+                    int capacidade;
+                    printf("Nova capacidade (Mbps): ");
+                    scanf("%d", &capacidade);
+
+                    // Guarda a capacidade atual para desfazer se o histórico falhar
+                    int anterior = 0;
+                    if (origem >= 0 && origem < rede->num_vertices) {
+                        for (Aresta* a = rede->vertices[origem].lista_adjacencia; a; a = a->proxima) {
+                            if (a->destino == destino) anterior = a->capacidade;
+                        }
+                    }
+
+                    if (!definir_capacidade_aresta(rede, origem, destino, capacidade)) {
+                        printf("Erro ao atualizar capacidade! Verifique os IDs e o valor informado.\n");
+                    } else if (!historico_definir_capacidade(historico, (long long)time(NULL), origem, destino, capacidade)) {
+                        definir_capacidade_aresta(rede, origem, destino, anterior);
+                        printf("Erro ao registrar no histórico! Capacidade não alterada.\n");
+                    } else {
+                        printf("Capacidade atualizada com sucesso!\n");
+                    }
+                }
+                break;
+
+            case 11: // Calcular capacidade máxima (fluxo máximo)
+                {
+                    printf("\n--- Capacidade Máxima entre Grupos ---\n");
+                    exibir_dispositivos(rede);
+
+                    if (rede->num_vertices < 2) {
+                        printf("É necessário pelo menos 2 dispositivos para calcular a capacidade.\n");
+                        break;
+                    }
+
+                    int* origens = (int*)malloc(rede->num_vertices * sizeof(int));
+                    int* destinos = (int*)malloc(rede->num_vertices * sizeof(int));
+                    int* corte = (int*)malloc((2 * contar_arestas(rede) + 1) * sizeof(int));
+
+                    if (!origens || !destinos || !corte) {
+                        printf("Erro ao alocar memória!\n");
+                        free(origens);
+                        free(destinos);
+                        free(corte);
+                        break;
+                    }
+
+                    int num_origens = ler_grupo_dispositivos(rede, "origem", origens);
+                    int num_destinos = num_origens ? ler_grupo_dispositivos(rede, "destino", destinos) : 0;
+
+                    if (num_origens && num_destinos) {
+                        int tamanho_corte = 0;
+                        long long fluxo = calcular_fluxo_maximo(rede, origens, num_origens,
+                                                                destinos, num_destinos,
+                                                                corte, &tamanho_corte);
+                        if (fluxo < 0) {
+                            printf("Erro ao calcular fluxo! Um dispositivo não pode estar nos dois grupos.\n");
+                        } else {
+                            printf("\nCapacidade máxima: %lld Mbps\n", fluxo);
+                            printf("Conexões do corte mínimo (gargalos):\n");
+                            for (int i = 0; i < tamanho_corte; i++) {
+                                int u = corte[2 * i];
+                                int v = corte[2 * i + 1];
+                                printf("  %s (%d) --- %s (%d)\n",
+                                       rede->vertices[u].nome, u + 1,
+                                       rede->vertices[v].nome, v + 1);
+                            }
+                            if (tamanho_corte == 0) {
+                                printf("  Nenhuma (os grupos não estão conectados)\n");
+                            }
+                        }
+                    }
+
+                    free(origens);
+                    free(destinos);
+                    free(corte);
+                }
+                break;
+
+            case 12: // Simular tráfego
+                {
+                    printf("\n--- Simular Tráfego ---\n");
+                    printf("Arquivo de fluxos (origem destino taxa_mbps inicio_s duracao_s): ");
+                    char caminho_arquivo[256];
+                    scanf(" %255[^\n]", caminho_arquivo);
+
+                    FluxoTrafego* fluxos = NULL;
+                    int num_fluxos = ler_fluxos_arquivo(caminho_arquivo, &fluxos);
+                    if (num_fluxos < 0) {
+                        printf("Erro ao ler o arquivo de fluxos!\n");
+                        break;
+                    }
+
+                    int num_enlaces = 2 * contar_arestas(rede);
+                    UsoEnlace* enlaces = (UsoEnlace*)malloc((num_enlaces + 1) * sizeof(UsoEnlace));
+                    ResultadoSimulacao resultado;
+
+                    if (enlaces && simular_trafego(rede, fluxos, num_fluxos, &resultado, enlaces)) {
+                        exibir_simulacao(rede, &resultado, enlaces, num_enlaces);
+                    } else {
+                        printf("Erro ao executar a simulação!\n");
+                    }
+
+                    free(fluxos);
+                    free(enlaces);
+                }
+                break;
+
+            case 13: // Dispositivos críticos (centralidade)
+                {
+                    printf("\n--- Dispositivos Críticos ---\n");
+
+                    if (rede->num_vertices < 3) {
+                        printf("É necessário pelo menos 3 dispositivos para calcular a centralidade.\n");
+                        break;
+                    }
+
+                    int amostras, top_n;
+                    printf("Número de fontes amostradas (0 = cálculo exato): ");
+                    scanf("%d", &amostras);
+                    printf("Quantidade de dispositivos por tipo (top N): ");
+                    scanf("%d", &top_n);
+
+                    if (top_n <= 0) {
+                        printf("Quantidade inválida!\n");
+                        break;
+                    }
+
+                    double* centralidade = (double*)malloc(rede->num_vertices * sizeof(double));
+                    int* ids = (int*)malloc(top_n * sizeof(int));
+
+                    if (!centralidade || !ids ||
+                        !calcular_centralidade(rede, centralidade, amostras, 0)) {
+                        printf("Erro ao calcular a centralidade!\n");
+                        free(centralidade);
+                        free(ids);
+                        break;
+                    }
+
+                    TipoDispositivo tipos[] = { SWITCH, ACCESS_POINT, SERVIDOR, COMPUTADOR };
+                    for (int t = 0; t < 4; t++) {
+                        int quantidade = ranquear_centralidade(rede, centralidade, tipos[t], ids, top_n);
+                        if (quantidade == 0) continue;
+
+                        printf("\n%s:\n", tipo_dispositivo_str(tipos[t]));
+                        for (int i = 0; i < quantidade; i++) {
+                            printf("  %d. %s (%d): %.2f caminhos\n",
+                                   i + 1,
+                                   rede->vertices[ids[i]].nome,
+                                   ids[i] + 1,
+                                   centralidade[ids[i]]);
+                        }
+                    }
+
+                    free(centralidade);
+                    free(ids);
+                }
+                break;
+
+            case 14: // Exportar rede para arquivo mapeado
+                {
+                    char caminho_arquivo[256];
+                    printf("Nome do arquivo: ");
+                    scanf(" %255[^\n]", caminho_arquivo);
+
+                    if (exportar_grafo_mapeado(rede, caminho_arquivo)) {
+                        printf("Rede exportada com sucesso em '%s'!\n", caminho_arquivo);
+                    } else {
+                        printf("Erro ao exportar a rede!\n");
+                    }
+                }
+                break;
+
+            case 15: // Consultar arquivo mapeado
+                {
+                    char caminho_arquivo[256];
+                    printf("Nome do arquivo: ");
+                    scanf(" %255[^\n]", caminho_arquivo);
+
+                    GrafoMapeado* gm = abrir_grafo_mapeado(caminho_arquivo);
+                    if (!gm) {
+                        printf("Erro ao abrir o arquivo! Verifique se foi gerado pela opção 14.\n");
+                        break;
+                    }
+
+                    consultar_grafo_mapeado(gm);
+                    fechar_grafo_mapeado(gm);
+                }
+                break;
+
+            case 16: // Reordenar dispositivos
+                {
+                    printf("\n--- Reordenar Dispositivos ---\n");
+                    printf("Critério:\n");
+                    printf("0 - Reverse Cuthill-McKee (BFS)\n");
+                    printf("1 - Hierarquia de switches\n");
+                    printf("2 - Consultar um ID externo (numeração anterior às reordenações)\n");
+                    printf("Escolha: ");
+                    int criterio;
+                    scanf("%d", &criterio);
+
+                    if (criterio < 0 || criterio > 2) {
+                        printf("Critério inválido!\n");
+                        break;
+                    }
+
+                    if (criterio == 2) {
+                        int externo;
+                        printf("ID externo: ");
+                        scanf("%d", &externo);
+                        int indice = resolver_id_externo(rede, externo - 1);
+                        if (indice < 0) {
+                            printf("Nenhum dispositivo com esse ID externo (removido ou inexistente).\n");
+                        } else {
+                            printf("ID externo %d = %s (ID atual %d)\n", externo,
+                                   rede->vertices[indice].nome, indice + 1);
+                        }
+                        break;
+                    }
+
+                    // O inverso é alocado antes: desfazer a reordenação não pode falhar
+                    int* novo_id = (int*)malloc((rede->num_vertices + 1) * sizeof(int));
+                    int* inverso = (int*)malloc((rede->num_vertices + 1) * sizeof(int));
+                    if (!novo_id || !inverso) {
+                        printf("Erro ao alocar memória!\n");
+                        free(novo_id);
+                        free(inverso);
+                        break;
+                    }
+
+                    if (reordenar_vertices(rede, (CriterioReordenacao)criterio, novo_id)) {
+                        // O histórico usa índices: sem registrar a nova numeração, as próximas
+                        // alterações apontariam para os dispositivos errados
+                        if (historico_registrar_grafo(historico, (long long)time(NULL), rede, "dispositivos reordenados") < 0) {
+                            for (int antigo = 0; antigo < rede->num_vertices; antigo++) {
+                                inverso[novo_id[antigo]] = antigo;
+                            }
+                            renumerar_vertices(rede, inverso);
+                            printf("Erro ao registrar no histórico! A reordenação foi desfeita.\n");
+                            free(novo_id);
+                            free(inverso);
+                            break;
+                        }
+                        printf("Dispositivos reordenados! Nova numeração:\n");
+                        // novo_id é indexado pela posição antiga de cada dispositivo
+                        for (int antigo = 0; antigo < rede->num_vertices; antigo++) {
+                            int novo = novo_id[antigo];
+                            if (novo != antigo) {
+                                printf("  %s: %d -> %d\n", rede->vertices[novo].nome, antigo + 1, novo + 1);
+                            }
+                        }
+                    } else {
+                        printf("Erro ao reordenar dispositivos!\n");
+                    }
+
+                    free(novo_id);
+                    free(inverso);
+                }
+                break;
+
+            case 17: // Árvore de distribuição
+                {
+                    printf("\n--- Árvore de Distribuição ---\n");
+                    printf("0 - Árvore geradora mínima (toda a rede)\n");
+                    printf("1 - Servidores para todos os computadores\n");
+                    printf("2 - Escolher dispositivos\n");
+                    printf("Escolha: ");
+                    int modo;
+                    scanf("%d", &modo);
+
+                    if (modo < 0 || modo > 2) {
+                        printf("Opção inválida!\n");
+                        break;
+                    }
+
+                    int n = rede->num_vertices;
+                    ArestaArvore* arestas = (ArestaArvore*)malloc((n + 1) * sizeof(ArestaArvore));
+                    int* terminais = (int*)malloc((n + 1) * sizeof(int));
+                    if (!arestas || !terminais) {
+                        printf("Erro ao alocar memória!\n");
+                        free(arestas);
+                        free(terminais);
+                        break;
+                    }
+
+                    int num_arestas = 0, peso_total = 0, num_terminais = 0;
+                    int resultado = 0;
+                    if (modo == 0) {
+                        resultado = calcular_arvore_geradora(rede, arestas, &num_arestas, &peso_total);
+                        if (resultado > 1) {
+                            printf("Atenção: a rede tem %d partes desconectadas.\n", resultado);
+                        }
+                    } else {
+                        if (modo == 1) {
+                            for (int i = 0; i < n; i++) {
+                                if (rede->vertices[i].tipo == SERVIDOR || rede->vertices[i].tipo == COMPUTADOR) {
+                                    terminais[num_terminais++] = i;
+                                }
+                            }
+                        } else {
+                            exibir_dispositivos(rede);
+                            num_terminais = n > 0 ? ler_grupo_dispositivos(rede, "destino", terminais) : 0;
+                        }
+
+                        if (num_terminais > 0) {
+                            resultado = calcular_arvore_distribuicao(rede, terminais, num_terminais,
+                                                                     arestas, &num_arestas, &peso_total);
+                            if (resultado == 0) {
+                                printf("Atenção: nem todos os dispositivos escolhidos estão conectados.\n");
+                            }
+                        }
+                    }
+
+                    if (resultado < 0) {
+                        printf("Erro ao alocar memória!\n");
+                    } else if (num_arestas == 0) {
+                        printf("Nenhuma conexão na árvore.\n");
+                    } else {
+                        printf("\nConexões da árvore (%d, peso total %d):\n", num_arestas, peso_total);
+                        for (int i = 0; i < num_arestas; i++) {
+                            printf("  %s (%d) --- %s (%d) via %s\n",
+                                   rede->vertices[arestas[i].origem].nome, arestas[i].origem + 1,
+                                   rede->vertices[arestas[i].destino].nome, arestas[i].destino + 1,
+                                   tipo_conexao_str(arestas[i].tipo));
+                        }
+
+                        FILE* arquivo = fopen("arvore.mmd", "w");
+                        if (arquivo) {
+                            gerar_mermaid_arvore(rede, arestas, num_arestas, arquivo);
+                            fclose(arquivo);
+                            printf("Árvore gerada em 'arvore.mmd'!\n");
+                        }
+                    }
+
+                    free(arestas);
+                    free(terminais);
+                }
+                break;
+
+            case 18: // Histórico da topologia
+                if (!historico) {
+                    printf("Histórico indisponível!\n");
+                    break;
+                }
+                consultar_historico(historico);
+                break;
+
+            case 19: // Diâmetro e excentricidade
+                {
+                    printf("\n--- Diâmetro e Excentricidade ---\n");
+
+                    if (rede->num_vertices < 2) {
+                        printf("É necessário pelo menos 2 dispositivos para calcular o diâmetro.\n");
+                        break;
+                    }
+
+                    const char* criterios[] = { "peso", "saltos" };
+                    for (int por_saltos = 0; por_saltos <= 1; por_saltos++) {
+                        ResultadoDiametro r;
+                        if (!calcular_diametro(rede, por_saltos, &r)) {
+                            printf("Erro ao calcular o diâmetro!\n");
+                            break;
+                        }
+                        printf("Diâmetro por %s: %d, entre %s (%d) e %s (%d) [%d buscas]\n",
+                               criterios[por_saltos], r.diametro,
+                               rede->vertices[r.origem].nome, r.origem + 1,
+                               rede->vertices[r.destino].nome, r.destino + 1,
+                               r.buscas);
+                    }
+
+                    int top_n;
+                    printf("\nQuantidade de dispositivos com a pior rota a exibir (0 = nenhum): ");
+                    scanf("%d", &top_n);
+                    if (top_n <= 0) break;
+                    if (top_n > rede->num_vertices) top_n = rede->num_vertices;
+
+                    int* exc_peso = (int*)malloc(rede->num_vertices * sizeof(int));
+                    int* exc_saltos = (int*)malloc(rede->num_vertices * sizeof(int));
+                    char* exibido = (char*)calloc(rede->num_vertices, sizeof(char));
+
+                    if (!exc_peso || !exc_saltos || !exibido ||
+                        !calcular_excentricidades(rede, 0, exc_peso, NULL) ||
+                        !calcular_excentricidades(rede, 1, exc_saltos, NULL)) {
+                        printf("Erro ao calcular as excentricidades!\n");
+                        free(exc_peso);
+                        free(exc_saltos);
+                        free(exibido);
+                        break;
+                    }
+
+                    int centro = 0;
+                    for (int i = 1; i < rede->num_vertices; i++) {
+                        if (exc_peso[i] < exc_peso[centro]) centro = i;
+                    }
+                    printf("Dispositivo mais central: %s (%d), pior rota com peso %d\n",
+                           rede->vertices[centro].nome, centro + 1, exc_peso[centro]);
+
+                    printf("\nDispositivos com a pior rota (peso / saltos):\n");
+                    for (int k = 0; k < top_n; k++) {
+                        int pior = -1;
+                        for (int i = 0; i < rede->num_vertices; i++) {
+                            if (exibido[i]) continue;
+                            if (pior < 0 || exc_peso[i] > exc_peso[pior] ||
+                                (exc_peso[i] == exc_peso[pior] && exc_saltos[i] > exc_saltos[pior])) {
+                                pior = i;
+                            }
+                        }
+                        exibido[pior] = 1;
+                        printf("  %d. %s (%d): %d / %d\n", k + 1,
+                               rede->vertices[pior].nome, pior + 1, exc_peso[pior], exc_saltos[pior]);
+                    }
+
+                    free(exc_peso);
+                    free(exc_saltos);
+                    free(exibido);
+                }
+                break;
+
+            case 20: // Carga em lote
+                {
+                    printf("\n--- Carga em Lote ---\n");
+                    printf("Arquivo (linhas 'D tipo nome' e 'C origem destino tipo'): ");
+                    char caminho_arquivo[256];
+                    scanf(" %255[^\n]", caminho_arquivo);
+
+                    DispositivoLote* dispositivos = NULL;
+                    ConexaoLote* conexoes = NULL;
+                    int num_conexoes = 0;
+                    int num_dispositivos = ler_carga_arquivo(caminho_arquivo, &dispositivos, &conexoes, &num_conexoes);
+                    if (num_dispositivos < 0) {
+                        printf("Erro ao ler o arquivo de carga!\n");
+                        break;
+                    }
+
+                    int rejeitadas = 0;
+                    int inseridas = carregar_em_lote(rede, dispositivos, num_dispositivos,
+                                                     conexoes, num_conexoes, 0, &rejeitadas);
+                    if (inseridas < 0) {
+                        printf("Erro ao carregar a rede!\n");
+                    } else {
+                        printf("%d dispositivos e %d conexões adicionados", num_dispositivos, inseridas);
+                        if (rejeitadas > 0) {
+                            printf(" (%d conexões inválidas ou repetidas ignoradas)", rejeitadas);
+                        }
+                        printf("\n");
+                        // Só o que a carga acrescentou entra na nova versão
+                        if (historico_adicionar_lote(historico, (long long)time(NULL), dispositivos, num_dispositivos,
+                                                     conexoes, num_conexoes) != inseridas) {
+                            printf("Aviso: a carga não foi registrada no histórico.\n");
+                        }
+                    }
+
+                    free(dispositivos);
+                    free(conexoes);
+                }
+                break;
+
+            case 21: // Rede particionada
+                {
+                    printf("\n--- Dividir a Rede em Processos ---\n");
+                    printf("1 - Dividir a rede atual e gravar as partições\n");
+                    printf("2 - Abrir partições já gravadas\n");
+                    printf("Escolha: ");
+                    int modo;
+                    scanf("%d", &modo);
+
+                    if (modo != 1 && modo != 2) {
+                        printf("Opção inválida!\n");
+                        break;
+                    }
+                    if (modo == 1 && rede->num_vertices == 0) {
+                        printf("A rede está vazia!\n");
+                        break;
+                    }
+
+                    int max_particoes = 0;
+                    if (modo == 1) {
+                        printf("Número máximo de processos (0 = um por site): ");
+                        scanf("%d", &max_particoes);
+                    }
+
+                    char diretorio[256];
+                    printf("Diretório das partições: ");
+                    scanf(" %255[^\n]", diretorio);
+
+                    if (modo == 1) {
+                        int gravadas = gravar_rede_particionada(rede, max_particoes, diretorio);
+                        if (gravadas == 0) {
+                            printf("Erro ao dividir a rede!\n");
+                            break;
+                        }
+                        printf("%d partições gravadas em '%s'.\n", gravadas, diretorio);
+                    }
+
+                    RedeParticionada* particionada = abrir_rede_particionada(diretorio);
+                    if (!particionada) {
+                        printf("Erro ao abrir as partições em '%s'!\n", diretorio);
+                        break;
+                    }
+
+                    // A rede em memória só corresponde às partições que acabaram de ser gravadas
+                    int conferir = 0;
+                    if (modo == 1) {
+                        printf("Conferir cada rota com a rede completa? (1 = sim, 0 = não): ");
+                        scanf("%d", &conferir);
+                    }
+
+                    consultar_rede_particionada(particionada, modo == 1 ? rede : NULL, conferir);
+                    encerrar_rede_particionada(particionada);
+                }
+                break;
+
+            case 22: // Rota com restrições
+                {
+                    printf("\n--- Calcular Rota com Restrições ---\n");
+                    exibir_dispositivos(rede);
+
+                    if (rede->num_vertices < 2) {
+                        printf("É necessário ter pelo menos 2 dispositivos!\n");
+                        break;
+                    }
+
+                    printf("ID do dispositivo origem (1-%d): ", rede->num_vertices);
+                    scanf("%d", &origem);
+                    origem--;
+
+                    printf("ID do dispositivo destino (1-%d): ", rede->num_vertices);
+                    scanf("%d", &destino);
+                    destino--;
+
+                    if (origem < 0 || origem >= rede->num_vertices ||
+                        destino < 0 || destino >= rede->num_vertices || origem == destino) {
+                        printf("IDs inválidos!\n");
+                        break;
+                    }
+
+                    RestricaoRota restricao;
+                    memset(&restricao, 0, sizeof(restricao));
+
+                    printf("Conexões: 0-Satélite 1-WiFi 2-Cabo 3-Fibra\n");
+                    if (!ler_mascara_tipos("Conexões permitidas", &restricao.conexoes)) break;
+                    printf("Dispositivos: 0-Servidor 1-Switch 2-Computador 3-Access Point\n");
+                    if (!ler_mascara_tipos("Dispositivos permitidos no meio da rota", &restricao.dispositivos)) break;
+
+                    printf("Máximo de saltos (0 = sem limite): ");
+                    scanf("%d", &restricao.max_saltos);
+
+                    int* excluidos = (int*)malloc(rede->num_vertices * sizeof(int));
+                    int* caminho = (int*)malloc(rede->num_vertices * sizeof(int));
+                    if (!excluidos || !caminho) {
+                        printf("Erro ao alocar memória!\n");
+                        free(excluidos);
+                        free(caminho);
+                        break;
+                    }
+
+                    int excluir;
+                    printf("Excluir dispositivos da rota? (1-Sim, 0-Não): ");
+                    scanf("%d", &excluir);
+                    if (excluir) {
+                        restricao.num_excluidos = ler_grupo_dispositivos(rede, "excluídos", excluidos);
+                        restricao.excluidos = excluidos;
+
+                        // Rota sem as exclusões pedidas não responderia à pergunta
+                        if (restricao.num_excluidos == 0) {
+                            printf("Consulta cancelada.\n");
+                            free(excluidos);
+                            free(caminho);
+                            break;
+                        }
+                    }
+
+                    int tamanho_caminho = 0, peso = 0;
+                    if (encontrar_rota_restrita(rede, origem, destino, &restricao, caminho, &tamanho_caminho, &peso)) {
+                        printf("\nCaminho (peso %d, %d saltos):\n", peso, tamanho_caminho - 1);
+                        for (int i = 0; i < tamanho_caminho; i++) {
+                            printf("  %d. %s (%s)\n", i + 1, rede->vertices[caminho[i]].nome,
+                                   tipo_dispositivo_str(rede->vertices[caminho[i]].tipo));
+                        }
+                    } else {
+                        printf("Nenhuma rota atende às restrições.\n");
+                    }
+
+                    free(excluidos);
+                    free(caminho);
+                }
+                break;
+
             case 0: // Sair
                 printf("Encerrando programa...\n");
                 break;
@@ -457,6 +1893,7 @@ int main() {
 
     // Libera memória
     destruir_grafo(rede);
+    destruir_historico(historico);
 
     return 0;
 }
@@ -0,0 +1,1057 @@
+// Rede particionada em vários processos: cada partição (um site ou um grupo de sites
+// ligados por satélite) é gravada no formato mapeado e atendida por um processo próprio,
+// que só carrega as páginas da sua parte da rede. O coordenador guarda apenas a partição
+// de cada dispositivo e o grafo de fronteira (overlay): os dispositivos com conexão para
+// outra partição, as conexões entre partições e, dentro de cada partição, a distância
+// entre cada par de fronteiras. Uma rota entre partições combina as distâncias locais
+// da origem e do destino até as suas fronteiras com um Dijkstra sobre o overlay, e os
+// trechos são expandidos por buscas locais nos processos.
+//
+// A divisão fica gravada em um diretório (um arquivo mapeado por partição e um índice
+// com o overlay), de modo que o coordenador pode ser iniciado depois sem o grafo completo.
+//
+// Protocolo entre o coordenador e cada partição (socket Unix, IDs locais começando em 0):
+//   FRONTEIRA <k> <id1> ... <idk>  -> OK <n>  (dispositivos da partição)
+//   MATRIZ                         -> OK <k> seguido de k linhas com k distâncias
+//   DIST <origem>                  -> OK <k> <d1> ... <dk>  (até cada fronteira; -1 = inalcançável)
+//   ROTA <origem> <destino>        -> OK <peso> <n> <id1> ... <idn> | OK -1
+//   SAIR                           -> encerra o processo
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// Tipos de dispositivo
+typedef enum {
+    SERVIDOR,
+    SWITCH,
+    COMPUTADOR,
+    ACCESS_POINT
+} TipoDispositivo;
+
+// Tipos de conexão
+typedef enum {
+    SATELITE,
+    WIFI,
+    CABO,
+    FIBRA
+} TipoConexao;
+
+// Estrutura de uma aresta (conexão)
+typedef struct Aresta {
+    int destino;
+    TipoConexao tipo;
+    int capacidade; // Capacidade do enlace em Mbps
+    struct Aresta* proxima;
+} Aresta;
+
+// Estrutura de um vértice (dispositivo)
+typedef struct Vertice {
+    int id;
+    TipoDispositivo tipo;
+    char nome[50];
+    Aresta* lista_adjacencia;
+} Vertice;
+
+// Estrutura do grafo
+typedef struct {
+    Vertice* vertices;
+    int num_vertices;
+    int capacidade;
+    // Tradução de IDs externos, criada na primeira reordenação (antes dela, ID externo =
+    // índice). Um dispositivo novo recebe o próximo ID externo
+    int* id_externo;       // índice -> ID externo
+    int* indice_externo;   // ID externo -> índice atual (-1 = removido)
+    int num_externos;
+    int capacidade_externos;
+} Grafo;
+
+// Grafo mapeado em arquivo (somente leitura)
+typedef struct {
+    int tipo;
+    int grau;
+    long long primeiro_arco;
+    char nome[50];
+} VerticeMapeado;
+
+typedef struct {
+    int destino;
+    int tipo;
+    int capacidade;
+} ArcoMapeado;
+
+typedef struct {
+    int descritor;
+    void* base;
+    size_t tamanho;
+    int num_vertices;
+    long long num_arcos;
+    const VerticeMapeado* vertices;
+    const ArcoMapeado* arcos;
+} GrafoMapeado;
+
+// Processo que atende uma partição (visto pelo coordenador)
+typedef struct {
+    pid_t pid;
+    FILE* entrada;           // respostas do processo (NULL = processo descartado)
+    char* envio;             // comandos ainda não enviados (pelo mesmo socket)
+    size_t tamanho_envio;
+    size_t capacidade_envio;
+    int num_vertices;
+    int* id_global;          // ID local -> ID global
+    int num_fronteira;
+    int primeira_fronteira;  // índice no overlay da primeira fronteira desta partição
+    int* fronteira;          // IDs locais das fronteiras
+    int* distancias;         // num_fronteira x num_fronteira (-1 = inalcançável)
+    char arquivo[512];
+} ProcessoParticao;
+
+typedef struct RedeParticionada {
+    int num_vertices;
+    int* particao;           // ID global -> partição
+    int* id_local;           // ID global -> ID na partição
+    int* posicao_fronteira;  // ID global -> posição entre as fronteiras da partição (-1 = interno)
+    int* membros;            // IDs globais agrupados por partição (id_global dos processos)
+    int* posicao_caminho;    // posição de cada dispositivo no caminho em montagem (-1 = fora)
+
+    int num_particoes;
+    int maior_particao;
+    ProcessoParticao* processos;
+
+    // Overlay: conexões entre partições em formato CSR (os atalhos internos ficam nas matrizes)
+    int num_fronteira;
+    int* fronteira_global;   // índice no overlay -> ID global
+    int* inicio_cruzadas;
+    int* cruzadas;
+    int* peso_cruzadas;
+} RedeParticionada;
+
+// Índice de uma rede particionada gravada (PARTICAO_INDICE). Depois do cabeçalho vêm, em
+// int: particao[n], id_local[n], fronteira_global[nf] (agrupadas por partição),
+// inicio_cruzadas[nf + 1], cruzadas[nc] e peso_cruzadas[nc]
+typedef struct {
+    char assinatura[8];      // "REDEIDX"
+    int versao;
+    int num_vertices;
+    int num_particoes;
+    int num_fronteira;
+    int num_cruzadas;
+} CabecalhoIndice;
+
+#define INDICE_ASSINATURA "REDEIDX"
+#define INDICE_VERSAO 1
+#define PARTICAO_INDICE "indice_particoes.dat"
+
+// Entrada da fila de prioridade do Dijkstra sobre o overlay
+typedef struct {
+    int chave;
+    int vertice;
+} ItemOverlay;
+
+typedef struct {
+    ItemOverlay* itens;
+    int tamanho;
+    int capacidade;
+} FilaOverlay;
+
+// Declarações das funções do grafo usadas aqui
+int obter_peso_conexao(TipoConexao tipo);
+GrafoMapeado* abrir_grafo_mapeado(const char* caminho);
+void fechar_grafo_mapeado(GrafoMapeado* gm);
+int encontrar_rota_mapeado(GrafoMapeado* gm, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+int calcular_distancias_mapeado(GrafoMapeado* gm, int origem, int* distancia);
+int particionar_grafo(Grafo* g, int max_particoes, int* particao);
+int exportar_particao_mapeada(Grafo* g, const int* particao, const int* id_local, const int* membros, int num_membros, const char* caminho);
+
+int gravar_rede_particionada(Grafo* g, int max_particoes, const char* diretorio);
+RedeParticionada* abrir_rede_particionada(const char* diretorio);
+void encerrar_rede_particionada(RedeParticionada* r);
+int rota_particionada(RedeParticionada* r, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void info_rede_particionada(RedeParticionada* r, int* num_vertices, int* num_particoes, int* num_fronteira, int* maior_particao);
+int executar_particao(const char* caminho, int fd);
+
+
+// ===== Processo de partição =====
+
+// Atende os comandos do coordenador pelo descritor 'fd' até receber SAIR ou o socket
+// ser fechado. Retorna 0 ao encerrar normalmente, 1 em caso de erro
+int executar_particao(const char* caminho, int fd) {
+    GrafoMapeado* gm = abrir_grafo_mapeado(caminho);
+    int fd_saida = fd >= 0 ? dup(fd) : -1;
+    FILE* entrada = fd >= 0 ? fdopen(fd, "r") : NULL;
+    FILE* saida = fd_saida >= 0 ? fdopen(fd_saida, "w") : NULL;
+
+    int n = gm ? gm->num_vertices : 0;
+    int* distancia = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int* caminho_local = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int* fronteira = NULL;
+    int num_fronteira = 0;
+    int status = 1;
+
+    if (!gm || !entrada || !saida || !distancia || !caminho_local) {
+        fprintf(stderr, "Erro ao iniciar a partição '%s'!\n", caminho ? caminho : "");
+        goto fim;
+    }
+
+    char comando[16];
+    while (fscanf(entrada, "%15s", comando) == 1) {
+        if (strcmp(comando, "FRONTEIRA") == 0) {
+            int k;
+            if (fscanf(entrada, "%d", &k) != 1 || k < 0 || k > n) break;
+
+            int* nova = (int*)realloc(fronteira, (k > 0 ? k : 1) * sizeof(int));
+            if (!nova) break;
+            fronteira = nova;
+            num_fronteira = 0;
+            for (int i = 0; i < k; i++) {
+                if (fscanf(entrada, "%d", &fronteira[i]) != 1 ||
+                    fronteira[i] < 0 || fronteira[i] >= n) {
+                    goto fim;
+                }
+            }
+            num_fronteira = k;
+            fprintf(saida, "OK %d\n", n);
+        } else if (strcmp(comando, "MATRIZ") == 0) {
+            fprintf(saida, "OK %d\n", num_fronteira);
+            for (int i = 0; i < num_fronteira; i++) {
+                if (!calcular_distancias_mapeado(gm, fronteira[i], distancia)) goto fim;
+                for (int j = 0; j < num_fronteira; j++) {
+                    fprintf(saida, j ? " %d" : "%d", distancia[fronteira[j]]);
+                }
+                fprintf(saida, "\n");
+            }
+        } else if (strcmp(comando, "DIST") == 0) {
+            int origem;
+            if (fscanf(entrada, "%d", &origem) != 1 || origem < 0 || origem >= n) break;
+            if (num_fronteira > 0 && !calcular_distancias_mapeado(gm, origem, distancia)) break;
+
+            fprintf(saida, "OK %d", num_fronteira);
+            for (int j = 0; j < num_fronteira; j++) {
+                fprintf(saida, " %d", distancia[fronteira[j]]);
+            }
+            fprintf(saida, "\n");
+        } else if (strcmp(comando, "ROTA") == 0) {
+            int origem, destino;
+            if (fscanf(entrada, "%d %d", &origem, &destino) != 2 ||
+                origem < 0 || destino < 0 || origem >= n || destino >= n) {
+                break;
+            }
+
+            int tamanho = 0;
+            int peso = 0;
+            if (origem == destino) {
+                caminho_local[0] = origem;
+                tamanho = 1;
+            } else if (!encontrar_rota_mapeado(gm, origem, destino, caminho_local, &tamanho, &peso)) {
+                tamanho = 0;
+            }
+
+            if (tamanho == 0) {
+                fprintf(saida, "OK -1\n");
+            } else {
+                fprintf(saida, "OK %d %d", peso, tamanho);
+                for (int i = 0; i < tamanho; i++) {
+                    fprintf(saida, " %d", caminho_local[i]);
+                }
+                fprintf(saida, "\n");
+            }
+        } else if (strcmp(comando, "SAIR") == 0) {
+            status = 0;
+            break;
+        } else {
+            // Sem delimitador de linha confiável no fluxo de tokens: encerra
+            break;
+        }
+
+        if (fflush(saida) != 0) break;
+    }
+
+    // Fim da entrada sem SAIR: o coordenador terminou, não é erro
+    if (feof(entrada)) status = 0;
+
+fim:
+    if (entrada) {
+        fclose(entrada);
+    } else if (fd >= 0) {
+        close(fd);
+    }
+    if (saida) {
+        fclose(saida);
+    } else if (fd_saida >= 0) {
+        close(fd_saida);
+    }
+    fechar_grafo_mapeado(gm);
+    free(distancia);
+    free(caminho_local);
+    free(fronteira);
+    return status;
+}
+
+
+// ===== Coordenador =====
+
+static int fila_inserir(FilaOverlay* f, int chave, int vertice) {
+    if (f->tamanho == f->capacidade) {
+        int nova_capacidade = f->capacidade ? f->capacidade * 2 : 64;
+        ItemOverlay* itens = (ItemOverlay*)realloc(f->itens, nova_capacidade * sizeof(ItemOverlay));
+        if (!itens) return 0;
+        f->itens = itens;
+        f->capacidade = nova_capacidade;
+    }
+
+    int i = f->tamanho++;
+    while (i > 0 && f->itens[(i - 1) / 2].chave > chave) {
+        f->itens[i] = f->itens[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    f->itens[i].chave = chave;
+    f->itens[i].vertice = vertice;
+    return 1;
+}
+
+static ItemOverlay fila_remover(FilaOverlay* f) {
+    ItemOverlay topo = f->itens[0];
+    ItemOverlay ultimo = f->itens[--f->tamanho];
+
+    int i = 0;
+    while (2 * i + 1 < f->tamanho) {
+        int filho = 2 * i + 1;
+        if (filho + 1 < f->tamanho && f->itens[filho + 1].chave < f->itens[filho].chave) filho++;
+        if (f->itens[filho].chave >= ultimo.chave) break;
+        f->itens[i] = f->itens[filho];
+        i = filho;
+    }
+    if (f->tamanho > 0) f->itens[i] = ultimo;
+    return topo;
+}
+
+// Acrescenta um comando (ou parte dele) ao envio pendente do processo.
+// Retorna 0 se faltar memória
+static int comando_printf(ProcessoParticao* proc, const char* formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    int n = vsnprintf(NULL, 0, formato, args);
+    va_end(args);
+    if (n < 0) return 0;
+
+    if (proc->tamanho_envio + (size_t)n + 1 > proc->capacidade_envio) {
+        size_t capacidade = proc->capacidade_envio ? proc->capacidade_envio : 256;
+        while (proc->tamanho_envio + (size_t)n + 1 > capacidade) capacidade *= 2;
+        char* envio = (char*)realloc(proc->envio, capacidade);
+        if (!envio) return 0;
+        proc->envio = envio;
+        proc->capacidade_envio = capacidade;
+    }
+
+    va_start(args, formato);
+    vsnprintf(proc->envio + proc->tamanho_envio, proc->capacidade_envio - proc->tamanho_envio, formato, args);
+    va_end(args);
+    proc->tamanho_envio += (size_t)n;
+    return 1;
+}
+
+// Envia os comandos pendentes. MSG_NOSIGNAL: um processo que morreu devolve erro em vez
+// de derrubar o coordenador com SIGPIPE. Retorna 1 se tudo foi enviado
+static int comando_enviar(ProcessoParticao* proc) {
+    if (!proc->entrada) return 0;
+
+    size_t enviado = 0;
+    while (enviado < proc->tamanho_envio) {
+        ssize_t n = send(fileno(proc->entrada), proc->envio + enviado,
+                         proc->tamanho_envio - enviado, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        enviado += (size_t)n;
+    }
+
+    int ok = enviado == proc->tamanho_envio;
+    proc->tamanho_envio = 0;
+    return ok;
+}
+
+// Depois de um erro no meio de uma troca, respostas podem ter ficado sem leitura e as
+// próximas sairiam trocadas: o processo é descartado (ao fechar o socket ele termina) e
+// as consultas que dependem dele passam a falhar
+static void descartar_processo(ProcessoParticao* proc) {
+    if (!proc->entrada) return;
+
+    fclose(proc->entrada);
+    proc->entrada = NULL;
+    proc->tamanho_envio = 0;
+}
+
+// Lê "OK <k>" seguido de k inteiros. Retorna 1 se a resposta tem exatamente k valores
+static int ler_resposta_vetor(FILE* entrada, int* valores, int k) {
+    int recebidos;
+    if (fscanf(entrada, " OK %d", &recebidos) != 1 || recebidos != k) return 0;
+    for (int i = 0; i < k; i++) {
+        if (fscanf(entrada, "%d", &valores[i]) != 1) return 0;
+    }
+    return 1;
+}
+
+// Cria o processo da partição ligado ao coordenador por um par de sockets Unix.
+// O processo é o próprio executável no modo --particao (só a partição fica na memória)
+static int iniciar_processo(ProcessoParticao* proc, const char* executavel) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) return 0;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+
+    if (pid == 0) {
+        char descritor[16];
+        snprintf(descritor, sizeof(descritor), "%d", fds[1]);
+        fcntl(fds[1], F_SETFD, 0);
+        execl(executavel, executavel, "--particao", proc->arquivo, descritor, (char*)NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    proc->pid = pid;
+    proc->entrada = fdopen(fds[0], "r");
+    if (!proc->entrada) {
+        close(fds[0]);
+        return 0;
+    }
+    return 1;
+}
+
+// Encerra os processos e libera o coordenador (os arquivos gravados são mantidos)
+void encerrar_rede_particionada(RedeParticionada* r) {
+    if (!r) return;
+
+    for (int p = 0; p < r->num_particoes; p++) {
+        ProcessoParticao* proc = &r->processos[p];
+        if (proc->entrada) {
+            proc->tamanho_envio = 0;
+            if (comando_printf(proc, "SAIR\n")) comando_enviar(proc);
+            fclose(proc->entrada);
+        }
+        if (proc->pid > 0) {
+            while (waitpid(proc->pid, NULL, 0) < 0 && errno == EINTR) {
+            }
+        }
+        free(proc->fronteira);
+        free(proc->distancias);
+        free(proc->envio);
+    }
+
+    free(r->processos);
+    free(r->particao);
+    free(r->id_local);
+    free(r->posicao_fronteira);
+    free(r->membros);
+    free(r->posicao_caminho);
+    free(r->fronteira_global);
+    free(r->inicio_cruzadas);
+    free(r->cruzadas);
+    free(r->peso_cruzadas);
+    free(r);
+}
+
+// Divide a rede em partições por site (no máximo max_particoes; <= 0 = uma por site) e
+// grava em 'diretorio' um arquivo mapeado por partição (particao_<p>.map) e o índice com
+// a partição e o ID local de cada dispositivo, as fronteiras e as conexões entre
+// partições. Retorna o número de partições ou 0 em caso de erro
+int gravar_rede_particionada(Grafo* g, int max_particoes, const char* diretorio) {
+    if (!g || !diretorio || g->num_vertices == 0) return 0;
+
+    // O índice antigo sai primeiro: uma gravação interrompida não deixa um índice que
+    // descreve outra divisão ao lado das partições novas
+    char indice[512];
+    snprintf(indice, sizeof(indice), "%s/%s", diretorio, PARTICAO_INDICE);
+    unlink(indice);
+
+    RedeParticionada* r = (RedeParticionada*)calloc(1, sizeof(RedeParticionada));
+    if (!r) return 0;
+
+    int gravadas = 0;
+    int n = g->num_vertices;
+    r->num_vertices = n;
+    r->particao = (int*)malloc(n * sizeof(int));
+    r->id_local = (int*)malloc(n * sizeof(int));
+    r->posicao_fronteira = (int*)malloc(n * sizeof(int));
+    r->membros = (int*)malloc(n * sizeof(int));
+    if (!r->particao || !r->id_local || !r->posicao_fronteira || !r->membros) goto fim;
+
+    int k = particionar_grafo(g, max_particoes, r->particao);
+    if (k == 0) goto fim;
+
+    r->processos = (ProcessoParticao*)calloc(k, sizeof(ProcessoParticao));
+    if (!r->processos) goto fim;
+    r->num_particoes = k;
+
+    // IDs locais na ordem dos IDs globais; membros agrupados por partição
+    for (int v = 0; v < n; v++) {
+        ProcessoParticao* proc = &r->processos[r->particao[v]];
+        r->id_local[v] = proc->num_vertices++;
+    }
+    int inicio = 0;
+    for (int p = 0; p < k; p++) {
+        r->processos[p].id_global = r->membros + inicio;
+        inicio += r->processos[p].num_vertices;
+    }
+    for (int v = 0; v < n; v++) {
+        ProcessoParticao* proc = &r->processos[r->particao[v]];
+        proc->id_global[r->id_local[v]] = v;
+    }
+
+    // Fronteiras: dispositivos com alguma conexão para outra partição
+    int num_cruzadas = 0;
+    for (int v = 0; v < n; v++) {
+        r->posicao_fronteira[v] = -1;
+        for (Aresta* a = g->vertices[v].lista_adjacencia; a; a = a->proxima) {
+            if (r->particao[a->destino] != r->particao[v]) {
+                if (r->posicao_fronteira[v] < 0) {
+                    r->posicao_fronteira[v] = r->processos[r->particao[v]].num_fronteira++;
+                }
+                num_cruzadas++;
+            }
+        }
+    }
+
+    for (int p = 0; p < k; p++) {
+        r->processos[p].primeira_fronteira = r->num_fronteira;
+        r->num_fronteira += r->processos[p].num_fronteira;
+    }
+
+    int nf = r->num_fronteira > 0 ? r->num_fronteira : 1;
+    r->fronteira_global = (int*)malloc(nf * sizeof(int));
+    r->inicio_cruzadas = (int*)calloc(nf + 1, sizeof(int));
+    r->cruzadas = (int*)malloc((num_cruzadas > 0 ? num_cruzadas : 1) * sizeof(int));
+    r->peso_cruzadas = (int*)malloc((num_cruzadas > 0 ? num_cruzadas : 1) * sizeof(int));
+    if (!r->fronteira_global || !r->inicio_cruzadas || !r->cruzadas || !r->peso_cruzadas) goto fim;
+
+    for (int v = 0; v < n; v++) {
+        if (r->posicao_fronteira[v] < 0) continue;
+        ProcessoParticao* proc = &r->processos[r->particao[v]];
+        r->fronteira_global[proc->primeira_fronteira + r->posicao_fronteira[v]] = v;
+    }
+
+    // Conexões entre partições, agrupadas pelo índice de overlay da origem
+    for (int i = 0; i < r->num_fronteira; i++) {
+        int u = r->fronteira_global[i];
+        r->inicio_cruzadas[i + 1] = r->inicio_cruzadas[i];
+        for (Aresta* a = g->vertices[u].lista_adjacencia; a; a = a->proxima) {
+            int v = a->destino;
+            if (r->particao[v] == r->particao[u]) continue;
+
+            int j = r->inicio_cruzadas[i + 1]++;
+            r->cruzadas[j] = r->processos[r->particao[v]].primeira_fronteira + r->posicao_fronteira[v];
+            r->peso_cruzadas[j] = obter_peso_conexao(a->tipo);
+        }
+    }
+
+    for (int p = 0; p < k; p++) {
+        ProcessoParticao* proc = &r->processos[p];
+        snprintf(proc->arquivo, sizeof(proc->arquivo), "%s/particao_%d.map", diretorio, p);
+        if (!exportar_particao_mapeada(g, r->particao, r->id_local, proc->id_global,
+                                       proc->num_vertices, proc->arquivo)) {
+            goto fim;
+        }
+    }
+
+    // O índice é gravado por último
+    FILE* arquivo = fopen(indice, "wb");
+    if (!arquivo) goto fim;
+
+    CabecalhoIndice cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.assinatura, INDICE_ASSINATURA, sizeof(INDICE_ASSINATURA));
+    cab.versao = INDICE_VERSAO;
+    cab.num_vertices = n;
+    cab.num_particoes = k;
+    cab.num_fronteira = r->num_fronteira;
+    cab.num_cruzadas = num_cruzadas;
+
+    size_t tamanho_n = (size_t)n;
+    size_t tamanho_f = (size_t)r->num_fronteira;
+    size_t tamanho_c = (size_t)num_cruzadas;
+    int ok = fwrite(&cab, sizeof(cab), 1, arquivo) == 1 &&
+        fwrite(r->particao, sizeof(int), tamanho_n, arquivo) == tamanho_n &&
+        fwrite(r->id_local, sizeof(int), tamanho_n, arquivo) == tamanho_n &&
+        fwrite(r->fronteira_global, sizeof(int), tamanho_f, arquivo) == tamanho_f &&
+        fwrite(r->inicio_cruzadas, sizeof(int), tamanho_f + 1, arquivo) == tamanho_f + 1 &&
+        fwrite(r->cruzadas, sizeof(int), tamanho_c, arquivo) == tamanho_c &&
+        fwrite(r->peso_cruzadas, sizeof(int), tamanho_c, arquivo) == tamanho_c;
+    if (fclose(arquivo) != 0) ok = 0;
+
+    if (!ok) {
+        unlink(indice);
+        goto fim;
+    }
+    gravadas = k;
+
+fim:
+    encerrar_rede_particionada(r);
+    return gravadas;
+}
+
+// Inicia o coordenador a partir de uma divisão gravada por gravar_rede_particionada: lê
+// o índice, inicia um processo por partição e monta o overlay, sem o grafo completo.
+// Retorna NULL se o índice for inválido ou em caso de erro
+RedeParticionada* abrir_rede_particionada(const char* diretorio) {
+    if (!diretorio) return NULL;
+
+    char executavel[512];
+    ssize_t tamanho_exe = readlink("/proc/self/exe", executavel, sizeof(executavel) - 1);
+    if (tamanho_exe <= 0) return NULL;
+    executavel[tamanho_exe] = '\0';
+
+    char caminho[512];
+    snprintf(caminho, sizeof(caminho), "%s/%s", diretorio, PARTICAO_INDICE);
+    FILE* arquivo = fopen(caminho, "rb");
+    if (!arquivo) return NULL;
+
+    RedeParticionada* r = (RedeParticionada*)calloc(1, sizeof(RedeParticionada));
+    CabecalhoIndice cab;
+    int valido = r && fread(&cab, sizeof(cab), 1, arquivo) == 1 &&
+        memcmp(cab.assinatura, INDICE_ASSINATURA, sizeof(INDICE_ASSINATURA)) == 0 &&
+        cab.versao == INDICE_VERSAO && cab.num_vertices > 0 &&
+        cab.num_particoes > 0 && cab.num_particoes <= cab.num_vertices &&
+        cab.num_fronteira >= 0 && cab.num_fronteira <= cab.num_vertices &&
+        cab.num_cruzadas >= 0;
+    if (!valido) goto erro;
+
+    int n = cab.num_vertices;
+    int k = cab.num_particoes;
+    int nf = cab.num_fronteira;
+    int nc = cab.num_cruzadas;
+    r->num_vertices = n;
+    r->particao = (int*)malloc(n * sizeof(int));
+    r->id_local = (int*)malloc(n * sizeof(int));
+    r->posicao_fronteira = (int*)malloc(n * sizeof(int));
+    r->membros = (int*)malloc(n * sizeof(int));
+    r->posicao_caminho = (int*)malloc(n * sizeof(int));
+    r->fronteira_global = (int*)malloc((nf > 0 ? nf : 1) * sizeof(int));
+    r->inicio_cruzadas = (int*)malloc((nf + 1) * sizeof(int));
+    r->cruzadas = (int*)malloc((nc > 0 ? nc : 1) * sizeof(int));
+    r->peso_cruzadas = (int*)malloc((nc > 0 ? nc : 1) * sizeof(int));
+    r->processos = (ProcessoParticao*)calloc(k, sizeof(ProcessoParticao));
+    if (!r->particao || !r->id_local || !r->posicao_fronteira || !r->membros ||
+        !r->posicao_caminho || !r->fronteira_global || !r->inicio_cruzadas ||
+        !r->cruzadas || !r->peso_cruzadas || !r->processos) {
+        goto erro;
+    }
+    r->num_particoes = k;
+    r->num_fronteira = nf;
+
+    if (fread(r->particao, sizeof(int), n, arquivo) != (size_t)n ||
+        fread(r->id_local, sizeof(int), n, arquivo) != (size_t)n ||
+        fread(r->fronteira_global, sizeof(int), nf, arquivo) != (size_t)nf ||
+        fread(r->inicio_cruzadas, sizeof(int), nf + 1, arquivo) != (size_t)nf + 1 ||
+        fread(r->cruzadas, sizeof(int), nc, arquivo) != (size_t)nc ||
+        fread(r->peso_cruzadas, sizeof(int), nc, arquivo) != (size_t)nc) {
+        goto erro;
+    }
+    fclose(arquivo);
+    arquivo = NULL;
+
+    // Confere o índice: cada ID local aparece uma única vez na sua partição
+    for (int v = 0; v < n; v++) {
+        if (r->particao[v] < 0 || r->particao[v] >= k) goto erro;
+        r->processos[r->particao[v]].num_vertices++;
+        r->membros[v] = -1;
+        r->posicao_fronteira[v] = -1;
+        r->posicao_caminho[v] = -1;
+    }
+    int inicio = 0;
+    for (int p = 0; p < k; p++) {
+        r->processos[p].id_global = r->membros + inicio;
+        inicio += r->processos[p].num_vertices;
+        if (r->processos[p].num_vertices > r->maior_particao) {
+            r->maior_particao = r->processos[p].num_vertices;
+        }
+    }
+    for (int v = 0; v < n; v++) {
+        ProcessoParticao* proc = &r->processos[r->particao[v]];
+        int l = r->id_local[v];
+        if (l < 0 || l >= proc->num_vertices || proc->id_global[l] >= 0) goto erro;
+        proc->id_global[l] = v;
+    }
+
+    // Fronteiras agrupadas por partição, em ordem crescente de partição
+    for (int i = 0; i < nf; i++) {
+        int v = r->fronteira_global[i];
+        if (v < 0 || v >= n || r->posicao_fronteira[v] >= 0) goto erro;
+        if (i > 0 && r->particao[v] < r->particao[r->fronteira_global[i - 1]]) goto erro;
+
+        ProcessoParticao* proc = &r->processos[r->particao[v]];
+        if (proc->num_fronteira == 0) proc->primeira_fronteira = i;
+        r->posicao_fronteira[v] = proc->num_fronteira++;
+    }
+
+    for (int p = 0; p < k; p++) {
+        ProcessoParticao* proc = &r->processos[p];
+        int kf = proc->num_fronteira > 0 ? proc->num_fronteira : 1;
+        proc->fronteira = (int*)malloc(kf * sizeof(int));
+        proc->distancias = (int*)malloc((size_t)kf * kf * sizeof(int));
+        if (!proc->fronteira || !proc->distancias) goto erro;
+    }
+    for (int i = 0; i < nf; i++) {
+        int v = r->fronteira_global[i];
+        r->processos[r->particao[v]].fronteira[r->posicao_fronteira[v]] = r->id_local[v];
+    }
+
+    // Conexões entre partições: faixas em ordem e destinos em outra partição
+    if (r->inicio_cruzadas[0] != 0 || r->inicio_cruzadas[nf] != nc) goto erro;
+    for (int i = 0; i < nf; i++) {
+        if (r->inicio_cruzadas[i + 1] < r->inicio_cruzadas[i]) goto erro;
+        for (int c = r->inicio_cruzadas[i]; c < r->inicio_cruzadas[i + 1]; c++) {
+            int v = r->cruzadas[c];
+            if (v < 0 || v >= nf || r->peso_cruzadas[c] < 0 ||
+                r->particao[r->fronteira_global[v]] == r->particao[r->fronteira_global[i]]) {
+                goto erro;
+            }
+        }
+    }
+
+    for (int p = 0; p < k; p++) {
+        ProcessoParticao* proc = &r->processos[p];
+        snprintf(proc->arquivo, sizeof(proc->arquivo), "%s/particao_%d.map", diretorio, p);
+        if (!iniciar_processo(proc, executavel)) goto erro;
+    }
+
+    // Envia as fronteiras e pede as matrizes a todos antes de ler: os processos
+    // calculam as distâncias internas em paralelo
+    for (int p = 0; p < k; p++) {
+        ProcessoParticao* proc = &r->processos[p];
+        int ok = comando_printf(proc, "FRONTEIRA %d", proc->num_fronteira);
+        for (int j = 0; j < proc->num_fronteira && ok; j++) {
+            ok = comando_printf(proc, " %d", proc->fronteira[j]);
+        }
+        if (!ok || !comando_printf(proc, "\nMATRIZ\n") || !comando_enviar(proc)) goto erro;
+    }
+
+    // Uma partição com outro número de dispositivos não corresponde ao índice
+    for (int p = 0; p < k; p++) {
+        ProcessoParticao* proc = &r->processos[p];
+        int kf = proc->num_fronteira;
+        int tamanho, recebidos;
+
+        if (fscanf(proc->entrada, " OK %d", &tamanho) != 1 || tamanho != proc->num_vertices ||
+            fscanf(proc->entrada, " OK %d", &recebidos) != 1 || recebidos != kf) {
+            goto erro;
+        }
+        for (long long i = 0; i < (long long)kf * kf; i++) {
+            if (fscanf(proc->entrada, "%d", &proc->distancias[i]) != 1) goto erro;
+        }
+    }
+
+    return r;
+
+erro:
+    if (arquivo) fclose(arquivo);
+    encerrar_rede_particionada(r);
+    return NULL;
+}
+
+// Resumo da divisão: dispositivos, partições, vértices do overlay e tamanho da maior
+// partição
+void info_rede_particionada(RedeParticionada* r, int* num_vertices, int* num_particoes, int* num_fronteira, int* maior_particao) {
+    if (!r) return;
+
+    if (num_vertices) *num_vertices = r->num_vertices;
+    if (num_particoes) *num_particoes = r->num_particoes;
+    if (num_fronteira) *num_fronteira = r->num_fronteira;
+    if (maior_particao) *maior_particao = r->maior_particao;
+}
+
+// Acrescenta um dispositivo ao caminho em montagem. Se ele já está no caminho (trechos
+// unidos por conexões de peso 0), o laço é descartado, o que não aumenta o peso
+static void caminho_anexar(RedeParticionada* r, int* caminho, int* tamanho, int v) {
+    int pos = r->posicao_caminho[v];
+    if (pos >= 0) {
+        for (int i = pos + 1; i < *tamanho; i++) {
+            r->posicao_caminho[caminho[i]] = -1;
+        }
+        *tamanho = pos + 1;
+        return;
+    }
+
+    r->posicao_caminho[v] = *tamanho;
+    caminho[(*tamanho)++] = v;
+}
+
+// Lê a resposta de ROTA ("OK <peso> <n> <ids...>" ou "OK -1") em 'local'.
+// Retorna o número de dispositivos, 0 se não há rota ou -1 se a resposta é inválida
+static int ler_resposta_rota(ProcessoParticao* proc, int* peso, int* local) {
+    int n;
+    if (fscanf(proc->entrada, " OK %d", peso) != 1) return -1;
+    if (*peso < 0) return 0;
+    if (fscanf(proc->entrada, "%d", &n) != 1 || n <= 0 || n > proc->num_vertices) return -1;
+
+    for (int i = 0; i < n; i++) {
+        if (fscanf(proc->entrada, "%d", &local[i]) != 1 ||
+            local[i] < 0 || local[i] >= proc->num_vertices) {
+            return -1;
+        }
+    }
+    return n;
+}
+
+// Pede ao processo da partição 'p' a rota local entre dois IDs locais e a acrescenta ao
+// caminho (IDs globais). Retorna 1 em caso de sucesso; o processo é descartado se a
+// troca for interrompida
+static int anexar_trecho(RedeParticionada* r, int p, int origem, int destino,
+                         int* caminho, int* tamanho, int* local) {
+    ProcessoParticao* proc = &r->processos[p];
+
+    if (!comando_printf(proc, "ROTA %d %d\n", origem, destino)) return 0;
+
+    int peso;
+    int n = comando_enviar(proc) ? ler_resposta_rota(proc, &peso, local) : -1;
+    if (n < 0) {
+        descartar_processo(proc);
+        return 0;
+    }
+    if (n == 0) return 0; // contradiz a matriz de distâncias
+
+    for (int i = 0; i < n; i++) {
+        caminho_anexar(r, caminho, tamanho, proc->id_global[local[i]]);
+    }
+    return 1;
+}
+
+// Rota de menor peso entre dois dispositivos (IDs globais) combinando as partições.
+// Mesma convenção de encontrar_rota_dial: 'caminho' deve ter espaço para todos os
+// dispositivos e 'peso' (pode ser NULL) recebe o peso total. Retorna 1 se encontrou,
+// 0 se não há rota e -1 se faltou memória ou algum processo necessário falhou
+int rota_particionada(RedeParticionada* r, int origem, int destino,
+                      int* caminho, int* tamanho_caminho, int* peso) {
+    if (!r || !caminho || !tamanho_caminho ||
+        origem < 0 || destino < 0 ||
+        origem >= r->num_vertices || destino >= r->num_vertices ||
+        origem == destino) {
+        return 0;
+    }
+
+    int po = r->particao[origem];
+    int pd = r->particao[destino];
+    ProcessoParticao* proc_o = &r->processos[po];
+    ProcessoParticao* proc_d = &r->processos[pd];
+    if (!proc_o->entrada || !proc_d->entrada) return -1;
+
+    int nf = r->num_fronteira > 0 ? r->num_fronteira : 1;
+    int* dist_origem = (int*)malloc((proc_o->num_fronteira + 1) * sizeof(int));
+    int* dist_destino = (int*)malloc((proc_d->num_fronteira + 1) * sizeof(int));
+    int* distancia = (int*)malloc(nf * sizeof(int));
+    int* anterior = (int*)malloc(nf * sizeof(int));
+    int* sequencia = (int*)malloc(nf * sizeof(int));
+    int* local = (int*)malloc(r->maior_particao * sizeof(int));
+    FilaOverlay fila;
+    memset(&fila, 0, sizeof(fila));
+
+    int resultado = -1;
+    int tamanho = 0;
+
+    if (!dist_origem || !dist_destino || !distancia || !anterior || !sequencia || !local) goto fim;
+
+    // Distâncias locais até as fronteiras; com origem e destino na mesma partição,
+    // também a rota local (candidata sem sair da partição)
+    if (!comando_printf(proc_o, "DIST %d\n", r->id_local[origem]) ||
+        !comando_printf(proc_d, "DIST %d\n", r->id_local[destino]) ||
+        (po == pd && !comando_printf(proc_o, "ROTA %d %d\n", r->id_local[origem], r->id_local[destino]))) {
+        proc_o->tamanho_envio = 0;
+        proc_d->tamanho_envio = 0;
+        goto fim;
+    }
+
+    int peso_local = -1;
+    int n_local = 0;
+    if (!comando_enviar(proc_o) || !comando_enviar(proc_d) ||
+        !ler_resposta_vetor(proc_o->entrada, dist_origem, proc_o->num_fronteira) ||
+        !ler_resposta_vetor(proc_d->entrada, dist_destino, proc_d->num_fronteira) ||
+        (po == pd && (n_local = ler_resposta_rota(proc_o, &peso_local, local)) < 0)) {
+        descartar_processo(proc_o);
+        descartar_processo(proc_d);
+        goto fim;
+    }
+    for (int i = 0; i < n_local; i++) {
+        caminho_anexar(r, caminho, &tamanho, proc_o->id_global[local[i]]);
+    }
+
+    // Dijkstra sobre o overlay a partir das fronteiras da origem, parando quando nenhuma
+    // fronteira ainda na fila pode melhorar a melhor chegada ao destino
+    for (int i = 0; i < r->num_fronteira; i++) {
+        distancia[i] = -1;
+    }
+    for (int j = 0; j < proc_o->num_fronteira; j++) {
+        if (dist_origem[j] < 0) continue;
+        int i = proc_o->primeira_fronteira + j;
+        distancia[i] = dist_origem[j];
+        anterior[i] = -1;
+        if (!fila_inserir(&fila, distancia[i], i)) goto fim;
+    }
+
+    int melhor = peso_local;
+    int ultima = -1;
+    while (fila.tamanho > 0) {
+        ItemOverlay item = fila_remover(&fila);
+        int u = item.vertice;
+        if (item.chave != distancia[u]) continue;
+        if (melhor >= 0 && item.chave >= melhor) break;
+
+        int global_u = r->fronteira_global[u];
+        int pu = r->particao[global_u];
+        int ju = r->posicao_fronteira[global_u];
+
+        if (pu == pd && dist_destino[ju] >= 0 &&
+            (melhor < 0 || item.chave + dist_destino[ju] < melhor)) {
+            melhor = item.chave + dist_destino[ju];
+            ultima = u;
+        }
+
+        // Atalhos internos da partição
+        ProcessoParticao* proc = &r->processos[pu];
+        const int* linha = &proc->distancias[(size_t)ju * proc->num_fronteira];
+        for (int j = 0; j < proc->num_fronteira; j++) {
+            int v = proc->primeira_fronteira + j;
+            int novo = item.chave + linha[j];
+            if (j == ju || linha[j] < 0 || (distancia[v] >= 0 && novo >= distancia[v])) continue;
+            distancia[v] = novo;
+            anterior[v] = u;
+            if (!fila_inserir(&fila, novo, v)) goto fim;
+        }
+
+        // Conexões de satélite para outras partições
+        for (int c = r->inicio_cruzadas[u]; c < r->inicio_cruzadas[u + 1]; c++) {
+            int v = r->cruzadas[c];
+            int novo = item.chave + r->peso_cruzadas[c];
+            if (distancia[v] >= 0 && novo >= distancia[v]) continue;
+            distancia[v] = novo;
+            anterior[v] = u;
+            if (!fila_inserir(&fila, novo, v)) goto fim;
+        }
+    }
+
+    if (ultima >= 0) {
+        // A rota pelo overlay é melhor que a local: troca o caminho
+        for (int i = 0; i < tamanho; i++) {
+            r->posicao_caminho[caminho[i]] = -1;
+        }
+        tamanho = 0;
+
+        int num_sequencia = 0;
+        for (int u = ultima; u != -1; u = anterior[u]) {
+            sequencia[num_sequencia++] = u;
+        }
+
+        // Origem -> primeira fronteira, trechos do overlay e última fronteira -> destino
+        int primeira = r->fronteira_global[sequencia[num_sequencia - 1]];
+        if (!anexar_trecho(r, po, r->id_local[origem], r->id_local[primeira], caminho, &tamanho, local)) {
+            goto fim;
+        }
+        for (int s = num_sequencia - 1; s > 0; s--) {
+            int a = r->fronteira_global[sequencia[s]];
+            int b = r->fronteira_global[sequencia[s - 1]];
+            if (r->particao[a] == r->particao[b]) {
+                if (!anexar_trecho(r, r->particao[a], r->id_local[a], r->id_local[b],
+                                   caminho, &tamanho, local)) {
+                    goto fim;
+                }
+            } else {
+                caminho_anexar(r, caminho, &tamanho, b);
+            }
+        }
+        int ultima_global = r->fronteira_global[ultima];
+        if (!anexar_trecho(r, pd, r->id_local[ultima_global], r->id_local[destino],
+                           caminho, &tamanho, local)) {
+            goto fim;
+        }
+    }
+
+    resultado = melhor >= 0 && tamanho > 0;
+    if (resultado) {
+        *tamanho_caminho = tamanho;
+        if (peso) *peso = melhor;
+    }
+
+fim:
+    for (int i = 0; i < tamanho; i++) {
+        r->posicao_caminho[caminho[i]] = -1;
+    }
+    free(dist_origem);
+    free(dist_destino);
+    free(distancia);
+    free(anterior);
+    free(sequencia);
+    free(local);
+    free(fila.itens);
+    return resultado;
+}
+
+#else
+
+typedef struct Grafo Grafo;
+typedef struct RedeParticionada RedeParticionada;
+
+int gravar_rede_particionada(Grafo* g, int max_particoes, const char* diretorio);
+RedeParticionada* abrir_rede_particionada(const char* diretorio);
+void encerrar_rede_particionada(RedeParticionada* r);
+int rota_particionada(RedeParticionada* r, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void info_rede_particionada(RedeParticionada* r, int* num_vertices, int* num_particoes, int* num_fronteira, int* maior_particao);
+int executar_particao(const char* caminho, int fd);
+
+// Os processos de partição dependem de socketpair, fork e /proc, disponíveis apenas no Linux
+int gravar_rede_particionada(Grafo* g, int max_particoes, const char* diretorio) {
+    (void)g;
+    (void)max_particoes;
+    (void)diretorio;
+    fprintf(stderr, "A rede particionada está disponível apenas no Linux.\n");
+    return 0;
+}
+
+RedeParticionada* abrir_rede_particionada(const char* diretorio) {
+    (void)diretorio;
+    fprintf(stderr, "A rede particionada está disponível apenas no Linux.\n");
+    return NULL;
+}
+
+void encerrar_rede_particionada(RedeParticionada* r) {
+    (void)r;
+}
+
+int rota_particionada(RedeParticionada* r, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso) {
+    (void)r;
+    (void)origem;
+    (void)destino;
+    (void)caminho;
+    (void)tamanho_caminho;
+    (void)peso;
+    return 0;
+}
+
+void info_rede_particionada(RedeParticionada* r, int* num_vertices, int* num_particoes, int* num_fronteira, int* maior_particao) {
+    (void)r;
+    (void)num_vertices;
+    (void)num_particoes;
+    (void)num_fronteira;
+    (void)maior_particao;
+}
+
+int executar_particao(const char* caminho, int fd) {
+    (void)caminho;
+    (void)fd;
+    fprintf(stderr, "A rede particionada está disponível apenas no Linux.\n");
+    return 1;
+}
+
+#endif
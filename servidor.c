@@ -0,0 +1,1185 @@
+// Modo servidor (daemon): mantém o grafo em memória e atende requisições de rota,
+// alcançabilidade, alteração e exportação por um socket Unix ou TCP local.
+//
+// Protocolo de texto, um comando por linha (IDs começam em 1, como no menu):
+//   PING                         -> OK PONG
+//   ROTA <origem> <destino>      -> OK <peso> <n> <id1> ... <idn>
+//   ALCANCA <origem> <destino>   -> OK 1 | OK 0
+//   ADD_DISP <tipo> <nome>       -> OK <id>
+//   REM_DISP <id>                -> OK
+//   ADD_CONEXAO <o> <d> <tipo>   -> OK
+//   REM_CONEXAO <o> <d>          -> OK
+//   LISTAR                       -> OK <n> seguido de n linhas "<id> <tipo> <nome>"
+//   MERMAID                      -> OK <n> seguido de n linhas do diagrama
+//   VERSOES                      -> OK <n> seguido de n linhas "<versao> <instante> <dispositivos> <descricao>"
+//   ROTA_EM <instante> <o> <d>   -> como ROTA, na topologia vigente no instante (Unix, segundos)
+//   ROTA_RESTRITA <o> <d> <conexoes> <dispositivos> <max_saltos> [excluidos...]
+//                                -> como ROTA, com máscaras de bits dos tipos permitidos
+//                                   (0 = todos), limite de saltos (0 = sem) e IDs proibidos
+//   MERMAID_EM <instante>        -> como MERMAID, na topologia vigente no instante
+//   SAIR                         -> OK (fecha a conexão)
+// Erros são respondidos com "ERRO <motivo>". Vários comandos podem ser enviados sem
+// esperar as respostas (pipelining); as respostas voltam na mesma ordem.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// Tipos de dispositivo
+typedef enum {
+    SERVIDOR,
+    SWITCH,
+    COMPUTADOR,
+    ACCESS_POINT
+} TipoDispositivo;
+
+// Tipos de conexão
+typedef enum {
+    SATELITE,
+    WIFI,
+    CABO,
+    FIBRA
+} TipoConexao;
+
+// Estrutura de uma aresta (conexão)
+typedef struct Aresta {
+    int destino;
+    TipoConexao tipo;
+    int capacidade; // Capacidade do enlace em Mbps
+    struct Aresta* proxima;
+} Aresta;
+
+// Estrutura de um vértice (dispositivo)
+typedef struct Vertice {
+    int id;
+    TipoDispositivo tipo;
+    char nome[50];
+    Aresta* lista_adjacencia;
+} Vertice;
+
+// Estrutura do grafo
+typedef struct {
+    Vertice* vertices;
+    int num_vertices;
+    int capacidade;
+    // Tradução de IDs externos, criada na primeira reordenação (antes dela, ID externo =
+    // índice). Um dispositivo novo recebe o próximo ID externo
+    int* id_externo;       // índice -> ID externo
+    int* indice_externo;   // ID externo -> índice atual (-1 = removido)
+    int num_externos;
+    int capacidade_externos;
+} Grafo;
+
+// Histórico de versões da topologia (definido em grafo.c)
+typedef struct HistoricoGrafo HistoricoGrafo;
+
+// Restrições de uma consulta de rota (encontrar_rota_restrita)
+typedef struct {
+    unsigned int conexoes;      // bit (1 << TipoConexao) de cada conexão permitida; 0 = todas
+    unsigned int dispositivos;  // bit (1 << TipoDispositivo) de cada tipo permitido no meio da rota; 0 = todos
+    int max_saltos;             // número máximo de conexões na rota; <= 0 = sem limite
+    const int* excluidos;       // dispositivos que não podem aparecer na rota
+    int num_excluidos;
+} RestricaoRota;
+
+// Declarações das funções do grafo usadas pelo servidor
+int adicionar_vertice(Grafo* g, TipoDispositivo tipo, const char* nome);
+int adicionar_aresta(Grafo* g, int origem, int destino, TipoConexao tipo);
+int remover_aresta(Grafo* g, int origem, int destino);
+int remover_vertice(Grafo* g, int id);
+void gerar_mermaid(Grafo* g, FILE* arquivo);
+const char* tipo_dispositivo_str(TipoDispositivo tipo);
+int encontrar_rota_dial(Grafo* g, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+int encontrar_rota_restrita(Grafo* g, int origem, int destino, const RestricaoRota* restricao, int* caminho, int* tamanho_caminho, int* peso);
+HistoricoGrafo* criar_historico(Grafo* g, long long instante);
+void destruir_historico(HistoricoGrafo* h);
+int historico_adicionar_vertice(HistoricoGrafo* h, long long instante, TipoDispositivo tipo, const char* nome);
+int historico_adicionar_aresta(HistoricoGrafo* h, long long instante, int origem, int destino, TipoConexao tipo);
+int historico_remover_aresta(HistoricoGrafo* h, long long instante, int origem, int destino);
+int historico_remover_vertice(HistoricoGrafo* h, long long instante, int id);
+int historico_num_versoes(HistoricoGrafo* h);
+int historico_versao_em(HistoricoGrafo* h, long long instante);
+int historico_info_versao(HistoricoGrafo* h, int versao, long long* instante, int* num_vertices, const char** descricao);
+int encontrar_rota_versao(HistoricoGrafo* h, int versao, int origem, int destino, int* caminho, int* tamanho_caminho, int* peso);
+void gerar_mermaid_versao(HistoricoGrafo* h, int versao, FILE* arquivo);
+int executar_servidor(Grafo* g, const char* endereco, int num_threads);
+
+// Tamanho máximo de uma linha de comando
+#define SERVIDOR_MAX_LINHA 4096
+
+// Limites por conexão: com a entrada acumulada ou a saída ainda não enviada acima destes
+// valores, o servidor para de ler a conexão até o cliente consumir as respostas
+#define SERVIDOR_MAX_ENTRADA (256 * 1024)
+#define SERVIDOR_MAX_SAIDA (4 * 1024 * 1024)
+#define SERVIDOR_MAX_EVENTOS 256
+
+// Abaixo deste número de dispositivos as consultas são baratas e respondidas no próprio
+// laço; o custo de repassá-las ao pool seria maior que o da consulta
+#define SERVIDOR_LIMITE_POOL 4096
+
+// Destino de um comando (classificar_comando)
+#define COMANDO_LACO 0       // executado no laço de eventos (não toca o grafo ou é barato)
+#define COMANDO_CONSULTA 1   // pool de threads (trava de leitura)
+#define COMANDO_ALTERACAO 2  // thread de escrita (trava de escrita)
+
+// Buffer de bytes que cresce sob demanda
+typedef struct {
+    char* dados;
+    size_t inicio;   // bytes já consumidos
+    size_t tamanho;  // bytes válidos (a partir de 0)
+    size_t capacidade;
+} Buffer;
+
+// Estado de um cliente conectado
+typedef struct Conexao {
+    int fd;
+    Buffer entrada;
+    Buffer saida;
+    int ocupada;         // há um lote desta conexão no pool ou na thread de escrita
+    int fechar;          // fechar assim que a saída for enviada
+    int fim_entrada;     // cliente encerrou o envio (fecha após responder as linhas recebidas)
+    int encerrada;       // socket já fechado; liberar quando o lote voltar
+    unsigned int eventos; // eventos registrados no epoll
+    struct Conexao* anterior; // lista de conexões do servidor
+    struct Conexao* proxima;
+} Conexao;
+
+// Sequência de comandos de uma conexão processada fora do laço: consultas vão para uma
+// thread do pool, alterações para a thread de escrita
+typedef struct Lote {
+    Conexao* conexao;
+    char* comandos;      // linhas separadas por '\n'
+    size_t tamanho;
+    int alteracao;       // lote da thread de escrita
+    int num_vertices;    // tamanho do grafo após um lote de alterações
+    Buffer resposta;
+    struct Lote* proximo;
+} Lote;
+
+typedef struct {
+    Grafo* g;
+    HistoricoGrafo* historico; // versões anteriores (protegido pela mesma trava do grafo)
+    pthread_rwlock_t trava_grafo;
+
+    pthread_mutex_t trava_filas;
+    pthread_cond_t tem_trabalho;
+    pthread_cond_t tem_alteracao;
+    Lote* pendentes_inicio;
+    Lote* pendentes_fim;
+    Lote* alteracoes_inicio;
+    Lote* alteracoes_fim;
+    Lote* concluidos;
+
+    // Usados só pelo laço: o grafo é alterado pela thread de escrita, então o laço guarda
+    // o tamanho informado pelo último lote de alterações e quantos ainda estão na fila
+    int num_vertices;
+    int alteracoes_pendentes;
+    Conexao* conexoes; // conexões ainda não liberadas, para o encerramento
+
+    int fd_escuta;
+    int fd_reserva;  // descritor guardado para recusar conexões quando faltam descritores
+    int escuta_pausada; // fd_escuta fora do epoll até uma conexão ser fechada
+    int fd_evento;   // eventfd que acorda o laço principal quando um lote termina
+    int fd_epoll;
+    int encerrar;
+} Servidor;
+
+static volatile sig_atomic_t sinal_encerrar = 0;
+
+static void tratar_sinal(int sinal) {
+    (void)sinal;
+    sinal_encerrar = 1;
+}
+
+static int buffer_reservar(Buffer* b, size_t adicional) {
+    if (b->tamanho + adicional <= b->capacidade) return 1;
+
+    // Descarta o que já foi consumido antes de crescer
+    if (b->inicio > 0) {
+        memmove(b->dados, b->dados + b->inicio, b->tamanho - b->inicio);
+        b->tamanho -= b->inicio;
+        b->inicio = 0;
+        if (b->tamanho + adicional <= b->capacidade) return 1;
+    }
+
+    size_t nova = b->capacidade ? b->capacidade : 1024;
+    while (nova < b->tamanho + adicional) nova *= 2;
+
+    char* dados = (char*)realloc(b->dados, nova);
+    if (!dados) return 0;
+    b->dados = dados;
+    b->capacidade = nova;
+    return 1;
+}
+
+static int buffer_anexar(Buffer* b, const char* dados, size_t tamanho) {
+    if (!buffer_reservar(b, tamanho)) return 0;
+    memcpy(b->dados + b->tamanho, dados, tamanho);
+    b->tamanho += tamanho;
+    return 1;
+}
+
+static int buffer_printf(Buffer* b, const char* formato, ...) {
+    char temp[512];
+    va_list args;
+    va_start(args, formato);
+    int n = vsnprintf(temp, sizeof(temp), formato, args);
+    va_end(args);
+
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(temp)) return buffer_anexar(b, temp, (size_t)n);
+
+    if (!buffer_reservar(b, (size_t)n + 1)) return 0;
+    va_start(args, formato);
+    vsnprintf(b->dados + b->tamanho, (size_t)n + 1, formato, args);
+    va_end(args);
+    b->tamanho += (size_t)n;
+    return 1;
+}
+
+static void buffer_liberar(Buffer* b) {
+    free(b->dados);
+    memset(b, 0, sizeof(Buffer));
+}
+
+// Decide onde um comando é executado. Alterações sempre vão para a thread de escrita, para
+// que o laço nunca espere pela trava de escrita. Consultas ficam no laço em redes pequenas,
+// exceto enquanto houver alterações na fila (a trava de leitura poderia esperar por elas)
+static int classificar_comando(Servidor* srv, const char* linha) {
+    if (strncmp(linha, "ADD_DISP ", 9) == 0 ||
+        strncmp(linha, "REM_DISP ", 9) == 0 ||
+        strncmp(linha, "ADD_CONEXAO ", 12) == 0 ||
+        strncmp(linha, "REM_CONEXAO ", 12) == 0) {
+        return COMANDO_ALTERACAO;
+    }
+
+    int consulta = strncmp(linha, "ROTA ", 5) == 0 ||
+                   strncmp(linha, "ALCANCA ", 8) == 0 ||
+                   strncmp(linha, "ROTA_EM ", 8) == 0 ||
+                   strncmp(linha, "ROTA_RESTRITA ", 14) == 0 ||
+                   strncmp(linha, "LISTAR", 6) == 0 ||
+                   strncmp(linha, "MERMAID", 7) == 0 ||
+                   strncmp(linha, "VERSOES", 7) == 0;
+    if (!consulta) return COMANDO_LACO;
+
+    return srv->num_vertices >= SERVIDOR_LIMITE_POOL || srv->alteracoes_pendentes > 0
+           ? COMANDO_CONSULTA : COMANDO_LACO;
+}
+
+// Valida um ID informado pelo cliente (começando em 1) e converte para índice
+static int converter_id(Grafo* g, int id) {
+    return (id >= 1 && id <= g->num_vertices) ? id - 1 : -1;
+}
+
+// Responde uma consulta de rota ou alcançabilidade (chamada com a trava de leitura)
+static void responder_rota(Servidor* srv, int origem, int destino, int somente_alcance, Buffer* resposta) {
+    Grafo* g = srv->g;
+    origem = converter_id(g, origem);
+    destino = converter_id(g, destino);
+
+    if (origem < 0 || destino < 0) {
+        buffer_printf(resposta, "ERRO id invalido\n");
+        return;
+    }
+    if (origem == destino) {
+        if (somente_alcance) {
+            buffer_printf(resposta, "OK 1\n");
+        } else {
+            buffer_printf(resposta, "OK 0 1 %d\n", origem + 1);
+        }
+        return;
+    }
+
+    int* caminho = (int*)malloc(g->num_vertices * sizeof(int));
+    if (!caminho) {
+        buffer_printf(resposta, "ERRO memoria\n");
+        return;
+    }
+
+    int tamanho = 0, peso = 0;
+    int encontrou = encontrar_rota_dial(g, origem, destino, caminho, &tamanho, &peso);
+
+    if (somente_alcance) {
+        buffer_printf(resposta, "OK %d\n", encontrou);
+    } else if (!encontrou) {
+        buffer_printf(resposta, "ERRO sem rota\n");
+    } else {
+        buffer_printf(resposta, "OK %d %d", peso, tamanho);
+        for (int i = 0; i < tamanho; i++) {
+            buffer_printf(resposta, " %d", caminho[i] + 1);
+        }
+        buffer_printf(resposta, "\n");
+    }
+
+    free(caminho);
+}
+
+// Rota com restrições; 'parametros' é o restante da linha após o comando
+// (chamada com a trava de leitura)
+static void responder_rota_restrita(Servidor* srv, const char* parametros, Buffer* resposta) {
+    Grafo* g = srv->g;
+    RestricaoRota restricao;
+    memset(&restricao, 0, sizeof(restricao));
+
+    int origem, destino, lidos;
+    unsigned int conexoes, dispositivos;
+    if (sscanf(parametros, "%d %d %u %u %d%n", &origem, &destino, &conexoes, &dispositivos,
+               &restricao.max_saltos, &lidos) != 5) {
+        buffer_printf(resposta, "ERRO parametros invalidos\n");
+        return;
+    }
+    restricao.conexoes = conexoes;
+    restricao.dispositivos = dispositivos;
+
+    origem = converter_id(g, origem);
+    destino = converter_id(g, destino);
+    if (origem < 0 || destino < 0) {
+        buffer_printf(resposta, "ERRO id invalido\n");
+        return;
+    }
+
+    int* excluidos = (int*)malloc(g->num_vertices * sizeof(int));
+    int* caminho = (int*)malloc(g->num_vertices * sizeof(int));
+    unsigned char* excluido = (unsigned char*)calloc(g->num_vertices, sizeof(unsigned char));
+    if (!excluidos || !caminho || !excluido) {
+        buffer_printf(resposta, "ERRO memoria\n");
+        goto fim;
+    }
+
+    // IDs excluídos até o fim da linha (repetidos contam uma vez)
+    const char* atual = parametros + lidos;
+    for (;;) {
+        while (*atual == ' ' || *atual == '\t') atual++;
+        if (*atual == '\0') break;
+
+        int id, avanco;
+        if (sscanf(atual, "%d%n", &id, &avanco) != 1) {
+            buffer_printf(resposta, "ERRO parametros invalidos\n");
+            goto fim;
+        }
+        if (converter_id(g, id) < 0) {
+            buffer_printf(resposta, "ERRO id invalido\n");
+            goto fim;
+        }
+        if (!excluido[id - 1]) {
+            excluido[id - 1] = 1;
+            excluidos[restricao.num_excluidos++] = id - 1;
+        }
+        atual += avanco;
+    }
+    restricao.excluidos = excluidos;
+
+    int tamanho = 0, peso = 0;
+    if (origem == destino) {
+        if (excluido[origem]) {
+            buffer_printf(resposta, "ERRO sem rota\n");
+        } else {
+            buffer_printf(resposta, "OK 0 1 %d\n", origem + 1);
+        }
+    } else if (encontrar_rota_restrita(g, origem, destino, &restricao, caminho, &tamanho, &peso)) {
+        buffer_printf(resposta, "OK %d %d", peso, tamanho);
+        for (int i = 0; i < tamanho; i++) {
+            buffer_printf(resposta, " %d", caminho[i] + 1);
+        }
+        buffer_printf(resposta, "\n");
+    } else {
+        buffer_printf(resposta, "ERRO sem rota\n");
+    }
+
+fim:
+    free(excluidos);
+    free(caminho);
+    free(excluido);
+}
+
+// Rota na versão vigente em 'instante' (chamada com a trava de leitura)
+static void responder_rota_historico(Servidor* srv, long long instante, int origem, int destino, Buffer* resposta) {
+    int versao = historico_versao_em(srv->historico, instante);
+    int num_vertices = 0;
+    if (versao < 0 || !historico_info_versao(srv->historico, versao, NULL, &num_vertices, NULL)) {
+        buffer_printf(resposta, "ERRO instante anterior ao historico\n");
+        return;
+    }
+    if (origem < 1 || origem > num_vertices || destino < 1 || destino > num_vertices) {
+        buffer_printf(resposta, "ERRO id invalido\n");
+        return;
+    }
+    if (origem == destino) {
+        buffer_printf(resposta, "OK 0 1 %d\n", origem);
+        return;
+    }
+
+    int* caminho = (int*)malloc(num_vertices * sizeof(int));
+    if (!caminho) {
+        buffer_printf(resposta, "ERRO memoria\n");
+        return;
+    }
+
+    int tamanho = 0, peso = 0;
+    if (encontrar_rota_versao(srv->historico, versao, origem - 1, destino - 1, caminho, &tamanho, &peso)) {
+        buffer_printf(resposta, "OK %d %d", peso, tamanho);
+        for (int i = 0; i < tamanho; i++) {
+            buffer_printf(resposta, " %d", caminho[i] + 1);
+        }
+        buffer_printf(resposta, "\n");
+    } else {
+        buffer_printf(resposta, "ERRO sem rota\n");
+    }
+
+    free(caminho);
+}
+
+// Responde com o diagrama Mermaid do grafo atual (versao < 0) ou de uma versão do histórico
+static void responder_mermaid(Servidor* srv, int versao, Buffer* resposta) {
+    char* texto = NULL;
+    size_t tamanho = 0;
+    FILE* memoria = open_memstream(&texto, &tamanho);
+    if (!memoria) {
+        buffer_printf(resposta, "ERRO memoria\n");
+        return;
+    }
+
+    pthread_rwlock_rdlock(&srv->trava_grafo);
+    if (versao < 0) {
+        gerar_mermaid(srv->g, memoria);
+    } else {
+        gerar_mermaid_versao(srv->historico, versao, memoria);
+    }
+    pthread_rwlock_unlock(&srv->trava_grafo);
+    fclose(memoria);
+
+    int linhas = 0;
+    for (size_t i = 0; i < tamanho; i++) {
+        if (texto[i] == '\n') linhas++;
+    }
+    buffer_printf(resposta, "OK %d\n", linhas);
+    buffer_anexar(resposta, texto, tamanho);
+    free(texto);
+}
+
+// Executa um comando e escreve a resposta. 'fechar' indica que o cliente pediu SAIR
+static void processar_comando(Servidor* srv, char* linha, Buffer* resposta, int* fechar) {
+    Grafo* g = srv->g;
+    char nome[50];
+    int a, b, c;
+    long long instante;
+
+    // Remove o '\r' de clientes que enviam CRLF
+    size_t tam = strlen(linha);
+    if (tam > 0 && linha[tam - 1] == '\r') linha[tam - 1] = '\0';
+
+    if (linha[0] == '\0') return;
+
+    if (strcmp(linha, "PING") == 0) {
+        buffer_printf(resposta, "OK PONG\n");
+    } else if (strcmp(linha, "SAIR") == 0) {
+        buffer_printf(resposta, "OK\n");
+        *fechar = 1;
+    } else if (sscanf(linha, "ROTA %d %d", &a, &b) == 2) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        responder_rota(srv, a, b, 0, resposta);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+    } else if (sscanf(linha, "ALCANCA %d %d", &a, &b) == 2) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        responder_rota(srv, a, b, 1, resposta);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+    } else if (strcmp(linha, "LISTAR") == 0) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        buffer_printf(resposta, "OK %d\n", g->num_vertices);
+        for (int i = 0; i < g->num_vertices; i++) {
+            buffer_printf(resposta, "%d %s %s\n", i + 1,
+                          tipo_dispositivo_str(g->vertices[i].tipo), g->vertices[i].nome);
+        }
+        pthread_rwlock_unlock(&srv->trava_grafo);
+    } else if (strcmp(linha, "MERMAID") == 0) {
+        responder_mermaid(srv, -1, resposta);
+    } else if (strncmp(linha, "ROTA_RESTRITA ", 14) == 0) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        responder_rota_restrita(srv, linha + 14, resposta);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+    } else if (sscanf(linha, "ROTA_EM %lld %d %d", &instante, &a, &b) == 3) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        responder_rota_historico(srv, instante, a, b, resposta);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+    } else if (sscanf(linha, "MERMAID_EM %lld", &instante) == 1) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        int versao = historico_versao_em(srv->historico, instante);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+
+        if (versao < 0) {
+            buffer_printf(resposta, "ERRO instante anterior ao historico\n");
+        } else {
+            responder_mermaid(srv, versao, resposta);
+        }
+    } else if (strcmp(linha, "VERSOES") == 0) {
+        pthread_rwlock_rdlock(&srv->trava_grafo);
+        int num_versoes = historico_num_versoes(srv->historico);
+        buffer_printf(resposta, "OK %d\n", num_versoes);
+        for (int i = 0; i < num_versoes; i++) {
+            long long quando;
+            int dispositivos;
+            const char* descricao;
+            historico_info_versao(srv->historico, i, &quando, &dispositivos, &descricao);
+            buffer_printf(resposta, "%d %lld %d %s\n", i, quando, dispositivos, descricao);
+        }
+        pthread_rwlock_unlock(&srv->trava_grafo);
+    } else if (sscanf(linha, "ADD_DISP %d %49[^\n]", &a, nome) == 2) {
+        if (a < 0 || a > 3) {
+            buffer_printf(resposta, "ERRO tipo invalido\n");
+            return;
+        }
+        pthread_rwlock_wrlock(&srv->trava_grafo);
+        int id = adicionar_vertice(g, (TipoDispositivo)a, nome);
+        int registrado = id < 0 || historico_adicionar_vertice(srv->historico, (long long)time(NULL), (TipoDispositivo)a, nome) >= 0;
+        if (!registrado) remover_vertice(g, id);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+
+        if (!registrado) {
+            buffer_printf(resposta, "ERRO historico\n");
+        } else if (id >= 0) {
+            buffer_printf(resposta, "OK %d\n", id + 1);
+        } else {
+            buffer_printf(resposta, "ERRO capacidade maxima atingida\n");
+        }
+    } else if (sscanf(linha, "REM_DISP %d", &a) == 1) {
+        pthread_rwlock_wrlock(&srv->trava_grafo);
+        // O histórico é registrado antes: a remoção não tem como ser desfeita
+        int id = converter_id(g, a);
+        int registrado = id < 0 || historico_remover_vertice(srv->historico, (long long)time(NULL), id);
+        int ok = id >= 0 && registrado && remover_vertice(g, id);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+
+        buffer_printf(resposta, ok ? "OK\n" : !registrado ? "ERRO historico\n" : "ERRO id invalido\n");
+    } else if (sscanf(linha, "ADD_CONEXAO %d %d %d", &a, &b, &c) == 3) {
+        if (c < 0 || c > 3) {
+            buffer_printf(resposta, "ERRO tipo invalido\n");
+            return;
+        }
+        pthread_rwlock_wrlock(&srv->trava_grafo);
+        int ok = adicionar_aresta(g, a - 1, b - 1, (TipoConexao)c);
+        int registrado = !ok || historico_adicionar_aresta(srv->historico, (long long)time(NULL), a - 1, b - 1, (TipoConexao)c);
+        if (!registrado) remover_aresta(g, a - 1, b - 1);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+
+        buffer_printf(resposta, !registrado ? "ERRO historico\n" : ok ? "OK\n" : "ERRO conexao invalida ou existente\n");
+    } else if (sscanf(linha, "REM_CONEXAO %d %d", &a, &b) == 2) {
+        pthread_rwlock_wrlock(&srv->trava_grafo);
+        int origem = converter_id(g, a), destino = converter_id(g, b);
+        int existe = 0;
+        if (origem >= 0 && destino >= 0) {
+            for (Aresta* arco = g->vertices[origem].lista_adjacencia; arco && !existe; arco = arco->proxima) {
+                existe = (arco->destino == destino);
+            }
+        }
+        int registrado = !existe || historico_remover_aresta(srv->historico, (long long)time(NULL), origem, destino);
+        int ok = existe && registrado && remover_aresta(g, origem, destino);
+        pthread_rwlock_unlock(&srv->trava_grafo);
+
+        buffer_printf(resposta, ok ? "OK\n" : !registrado ? "ERRO historico\n" : "ERRO conexao nao encontrada\n");
+    } else {
+        buffer_printf(resposta, "ERRO comando desconhecido\n");
+    }
+}
+
+// Executa os comandos de um lote e o devolve ao laço principal
+static void executar_lote(Servidor* srv, Lote* lote) {
+    char* linha = lote->comandos;
+    char* fim = lote->comandos + lote->tamanho;
+    int fechar = 0;
+    while (linha < fim) {
+        char* quebra = memchr(linha, '\n', (size_t)(fim - linha));
+        *quebra = '\0';
+        processar_comando(srv, linha, &lote->resposta, &fechar);
+        linha = quebra + 1;
+    }
+
+    // Só a thread de escrita altera o grafo, então ela lê o tamanho sem trava
+    if (lote->alteracao) lote->num_vertices = srv->g->num_vertices;
+
+    pthread_mutex_lock(&srv->trava_filas);
+    lote->proximo = srv->concluidos;
+    srv->concluidos = lote;
+    pthread_mutex_unlock(&srv->trava_filas);
+
+    uint64_t um = 1;
+    ssize_t escrito = write(srv->fd_evento, &um, sizeof(um));
+    (void)escrito;
+}
+
+// Retira o primeiro lote de uma fila, esperando por trabalho. NULL ao encerrar
+static Lote* retirar_lote(Servidor* srv, Lote** inicio, Lote** fim, pthread_cond_t* tem_lote) {
+    pthread_mutex_lock(&srv->trava_filas);
+    while (!*inicio && !srv->encerrar) {
+        pthread_cond_wait(tem_lote, &srv->trava_filas);
+    }
+
+    // No encerramento os lotes ainda na fila ficam para o laço principal descartar
+    Lote* lote = srv->encerrar ? NULL : *inicio;
+    if (lote) {
+        *inicio = lote->proximo;
+        if (!*inicio) *fim = NULL;
+    }
+    pthread_mutex_unlock(&srv->trava_filas);
+    return lote;
+}
+
+// Thread do pool: processa lotes de consultas
+static void* thread_trabalhadora(void* arg) {
+    Servidor* srv = (Servidor*)arg;
+    Lote* lote;
+    while ((lote = retirar_lote(srv, &srv->pendentes_inicio, &srv->pendentes_fim, &srv->tem_trabalho))) {
+        executar_lote(srv, lote);
+    }
+    return NULL;
+}
+
+// Thread de escrita: aplica os lotes de alterações na ordem em que chegaram
+static void* thread_escritora(void* arg) {
+    Servidor* srv = (Servidor*)arg;
+    Lote* lote;
+    while ((lote = retirar_lote(srv, &srv->alteracoes_inicio, &srv->alteracoes_fim, &srv->tem_alteracao))) {
+        executar_lote(srv, lote);
+    }
+    return NULL;
+}
+
+static size_t buffer_pendente(const Buffer* b) {
+    return b->tamanho - b->inicio;
+}
+
+// Registra no epoll os eventos que a conexão precisa agora: leitura enquanto o cliente não
+// encerrou o envio e as filas estão abaixo dos limites; escrita enquanto houver saída
+static void atualizar_interesse(Servidor* srv, Conexao* c) {
+    unsigned int eventos = 0;
+    if (!c->fim_entrada &&
+        buffer_pendente(&c->entrada) < SERVIDOR_MAX_ENTRADA &&
+        buffer_pendente(&c->saida) < SERVIDOR_MAX_SAIDA) {
+        eventos |= EPOLLIN;
+    }
+    if (buffer_pendente(&c->saida) > 0) eventos |= EPOLLOUT;
+    if (eventos == c->eventos) return;
+
+    struct epoll_event ev;
+    ev.events = eventos;
+    ev.data.ptr = c;
+    epoll_ctl(srv->fd_epoll, EPOLL_CTL_MOD, c->fd, &ev);
+    c->eventos = eventos;
+}
+
+// Há uma linha completa ainda não processada
+static int tem_linha(const Conexao* c) {
+    return memchr(c->entrada.dados + c->entrada.inicio, '\n', buffer_pendente(&c->entrada)) != NULL;
+}
+
+static void liberar_conexao(Servidor* srv, Conexao* c) {
+    if (c->anterior) c->anterior->proxima = c->proxima;
+    else srv->conexoes = c->proxima;
+    if (c->proxima) c->proxima->anterior = c->anterior;
+
+    buffer_liberar(&c->entrada);
+    buffer_liberar(&c->saida);
+    free(c);
+}
+
+// Volta a escutar novas conexões depois de uma pausa por falta de descritores
+static void retomar_escuta(Servidor* srv) {
+    if (!srv->escuta_pausada) return;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &srv->fd_escuta;
+    if (epoll_ctl(srv->fd_epoll, EPOLL_CTL_ADD, srv->fd_escuta, &ev) == 0) {
+        srv->escuta_pausada = 0;
+    }
+}
+
+// Fecha o socket; a estrutura só é liberada quando não houver lote pendente
+static void fechar_conexao(Servidor* srv, Conexao* c) {
+    if (c->encerrada) return;
+
+    epoll_ctl(srv->fd_epoll, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->encerrada = 1;
+    retomar_escuta(srv);
+
+    if (!c->ocupada) {
+        liberar_conexao(srv, c);
+    }
+}
+
+// Envia o que puder da saída. Retorna 0 se a conexão foi fechada
+static int enviar_saida(Servidor* srv, Conexao* c) {
+    while (c->saida.inicio < c->saida.tamanho) {
+        ssize_t n = send(c->fd, c->saida.dados + c->saida.inicio,
+                         c->saida.tamanho - c->saida.inicio, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->saida.inicio += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            fechar_conexao(srv, c);
+            return 0;
+        }
+    }
+
+    if (c->saida.inicio == c->saida.tamanho) {
+        c->saida.inicio = 0;
+        c->saida.tamanho = 0;
+
+        // Fecha após SAIR ou depois de responder tudo o que o cliente enviou antes de encerrar
+        if (!c->ocupada && (c->fechar || (c->fim_entrada && !tem_linha(c)))) {
+            fechar_conexao(srv, c);
+            return 0;
+        }
+    }
+
+    atualizar_interesse(srv, c);
+    return 1;
+}
+
+// Consome as linhas completas da entrada em ordem. Comandos leves são executados no próprio
+// laço; uma sequência de consultas (ou de alterações) vira um lote para o pool (ou para a
+// thread de escrita) e a conexão para de ler comandos até o lote voltar, preservando a
+// ordem das respostas
+static void processar_entrada(Servidor* srv, Conexao* c) {
+    Buffer* in = &c->entrada;
+
+    while (!c->ocupada && !c->fechar && in->inicio < in->tamanho &&
+           buffer_pendente(&c->saida) < SERVIDOR_MAX_SAIDA) {
+        char* linha = in->dados + in->inicio;
+        char* quebra = memchr(linha, '\n', in->tamanho - in->inicio);
+
+        if (!quebra) {
+            if (in->tamanho - in->inicio > SERVIDOR_MAX_LINHA) {
+                buffer_printf(&c->saida, "ERRO linha muito longa\n");
+                c->fechar = 1;
+            }
+            break;
+        }
+
+        int destino = classificar_comando(srv, linha);
+        if (destino == COMANDO_LACO) {
+            *quebra = '\0';
+            processar_comando(srv, linha, &c->saida, &c->fechar);
+            in->inicio = (size_t)(quebra - in->dados) + 1;
+            continue;
+        }
+
+        // Agrupa os comandos consecutivos já recebidos com o mesmo destino
+        char* fim_lote = quebra + 1;
+        while (fim_lote < in->dados + in->tamanho) {
+            char* prox = memchr(fim_lote, '\n', (size_t)(in->dados + in->tamanho - fim_lote));
+            if (!prox || classificar_comando(srv, fim_lote) != destino) break;
+            fim_lote = prox + 1;
+        }
+
+        Lote* lote = (Lote*)calloc(1, sizeof(Lote));
+        size_t tamanho = (size_t)(fim_lote - linha);
+        if (!lote || !(lote->comandos = (char*)malloc(tamanho))) {
+            free(lote);
+            buffer_printf(&c->saida, "ERRO memoria\n");
+            c->fechar = 1;
+            break;
+        }
+
+        memcpy(lote->comandos, linha, tamanho);
+        lote->tamanho = tamanho;
+        lote->conexao = c;
+        lote->alteracao = (destino == COMANDO_ALTERACAO);
+        in->inicio = (size_t)(fim_lote - in->dados);
+        c->ocupada = 1;
+
+        Lote** inicio = lote->alteracao ? &srv->alteracoes_inicio : &srv->pendentes_inicio;
+        Lote** fim = lote->alteracao ? &srv->alteracoes_fim : &srv->pendentes_fim;
+        if (lote->alteracao) srv->alteracoes_pendentes++;
+
+        pthread_mutex_lock(&srv->trava_filas);
+        if (*fim) {
+            (*fim)->proximo = lote;
+        } else {
+            *inicio = lote;
+        }
+        *fim = lote;
+        pthread_cond_signal(lote->alteracao ? &srv->tem_alteracao : &srv->tem_trabalho);
+        pthread_mutex_unlock(&srv->trava_filas);
+    }
+
+    if (in->inicio == in->tamanho) {
+        in->inicio = 0;
+        in->tamanho = 0;
+    }
+}
+
+// Processa a entrada acumulada e envia as respostas. Retorna 0 se a conexão foi fechada
+static int atender_conexao(Servidor* srv, Conexao* c) {
+    processar_entrada(srv, c);
+    return enviar_saida(srv, c);
+}
+
+// Lê até o limite de entrada da conexão. Retorna 0 se a conexão foi fechada
+static int ler_conexao(Servidor* srv, Conexao* c) {
+    while (buffer_pendente(&c->entrada) < SERVIDOR_MAX_ENTRADA) {
+        if (!buffer_reservar(&c->entrada, 4096)) {
+            fechar_conexao(srv, c);
+            return 0;
+        }
+
+        ssize_t n = recv(c->fd, c->entrada.dados + c->entrada.tamanho,
+                         c->entrada.capacidade - c->entrada.tamanho, 0);
+        if (n > 0) {
+            c->entrada.tamanho += (size_t)n;
+        } else if (n == 0) {
+            // Cliente encerrou o envio: responde o que falta e fecha. atualizar_interesse
+            // deixa de escutar EPOLLIN para não ser acordado de novo pelo fim de arquivo
+            c->fim_entrada = 1;
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            fechar_conexao(srv, c);
+            return 0;
+        }
+    }
+
+    return atender_conexao(srv, c);
+}
+
+// Sem descritores livres a conexão pendente continuaria sinalizando o socket de escuta e o
+// laço giraria sem parar. O descritor reservado é liberado para aceitar e fechar a conexão
+// (o cliente vê o fechamento); sem ele, a escuta é pausada até uma conexão ser fechada.
+// Retorna 1 se uma conexão foi recusada e pode haver outras na fila
+static int recusar_conexao(Servidor* srv) {
+    if (srv->fd_reserva >= 0) {
+        close(srv->fd_reserva);
+        int fd = accept(srv->fd_escuta, NULL, NULL);
+        // accept reserva o descritor antes de olhar a fila: EMFILE não indica que há conexão
+        int vazia = fd < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if (fd >= 0) close(fd);
+        srv->fd_reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (srv->fd_reserva >= 0 && (fd >= 0 || vazia)) return fd >= 0;
+    }
+
+    if (epoll_ctl(srv->fd_epoll, EPOLL_CTL_DEL, srv->fd_escuta, NULL) == 0) {
+        srv->escuta_pausada = 1;
+    }
+    return 0;
+}
+
+static void aceitar_conexoes(Servidor* srv) {
+    while (!srv->escuta_pausada) {
+        int fd = accept(srv->fd_escuta, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if ((errno == EMFILE || errno == ENFILE) && recusar_conexao(srv)) continue;
+            return; // fila vazia, escuta pausada ou erro transitório
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um)); // ignorado em sockets Unix
+
+        Conexao* c = (Conexao*)calloc(1, sizeof(Conexao));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->eventos = EPOLLIN;
+
+        struct epoll_event ev;
+        ev.events = c->eventos;
+        ev.data.ptr = c;
+        if (epoll_ctl(srv->fd_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+
+        c->proxima = srv->conexoes;
+        if (srv->conexoes) srv->conexoes->anterior = c;
+        srv->conexoes = c;
+    }
+}
+
+static void liberar_lote(Lote* lote) {
+    buffer_liberar(&lote->resposta);
+    free(lote->comandos);
+    free(lote);
+}
+
+// Recolhe os lotes concluídos pelo pool e pela thread de escrita e devolve as respostas
+// aos clientes
+static void recolher_lotes(Servidor* srv) {
+    uint64_t contador;
+    ssize_t lido = read(srv->fd_evento, &contador, sizeof(contador));
+    (void)lido;
+
+    pthread_mutex_lock(&srv->trava_filas);
+    Lote* lote = srv->concluidos;
+    srv->concluidos = NULL;
+    pthread_mutex_unlock(&srv->trava_filas);
+
+    while (lote) {
+        Lote* prox = lote->proximo;
+        Conexao* c = lote->conexao;
+        c->ocupada = 0;
+        if (lote->alteracao) {
+            srv->alteracoes_pendentes--;
+            srv->num_vertices = lote->num_vertices;
+        }
+
+        if (c->encerrada) {
+            liberar_conexao(srv, c);
+        } else {
+            buffer_anexar(&c->saida, lote->resposta.dados, lote->resposta.tamanho);
+            atender_conexao(srv, c);
+        }
+
+        liberar_lote(lote);
+        lote = prox;
+    }
+}
+
+// Descarta uma lista de lotes sem tocar nas conexões
+static void liberar_lotes(Lote* lote) {
+    while (lote) {
+        Lote* prox = lote->proximo;
+        liberar_lote(lote);
+        lote = prox;
+    }
+}
+
+// Cria o socket de escuta: número = porta TCP em 127.0.0.1; caso contrário, caminho Unix
+static int criar_socket_escuta(const char* endereco) {
+    int fd;
+    char* fim;
+    long porta = strtol(endereco, &fim, 10);
+
+    if (*endereco != '\0' && *fim == '\0') {
+        if (porta <= 0 || porta > 65535) return -1;
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+
+        int um = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((unsigned short)porta);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_un addr;
+        if (strlen(endereco) >= sizeof(addr.sun_path)) return -1;
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, endereco);
+        unlink(endereco);
+
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+// Executa o servidor até receber SIGINT/SIGTERM.
+// num_threads <= 0 usa o número de processadores disponíveis.
+// Retorna 0 ao encerrar normalmente, 1 em caso de erro
+int executar_servidor(Grafo* g, const char* endereco, int num_threads) {
+    if (!g || !endereco) return 1;
+
+    if (num_threads <= 0) {
+        long processadores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = processadores > 0 ? (int)processadores : 1;
+    }
+
+    Servidor srv;
+    memset(&srv, 0, sizeof(srv));
+    srv.g = g;
+    srv.num_vertices = g->num_vertices;
+    srv.historico = criar_historico(g, (long long)time(NULL));
+    srv.fd_escuta = criar_socket_escuta(endereco);
+    srv.fd_reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    srv.fd_evento = eventfd(0, EFD_NONBLOCK);
+    srv.fd_epoll = epoll_create1(0);
+
+    pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+
+    if (!srv.historico || srv.fd_escuta < 0 || srv.fd_evento < 0 || srv.fd_epoll < 0 || !threads) {
+        fprintf(stderr, "Erro ao iniciar o servidor em '%s'!\n", endereco);
+        destruir_historico(srv.historico);
+        if (srv.fd_escuta >= 0) close(srv.fd_escuta);
+        if (srv.fd_reserva >= 0) close(srv.fd_reserva);
+        if (srv.fd_evento >= 0) close(srv.fd_evento);
+        if (srv.fd_epoll >= 0) close(srv.fd_epoll);
+        free(threads);
+        return 1;
+    }
+
+    pthread_rwlock_init(&srv.trava_grafo, NULL);
+    pthread_mutex_init(&srv.trava_filas, NULL);
+    pthread_cond_init(&srv.tem_trabalho, NULL);
+    pthread_cond_init(&srv.tem_alteracao, NULL);
+
+    // Os descritores de escuta e de evento são identificados pelo endereço do campo
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &srv.fd_escuta;
+    epoll_ctl(srv.fd_epoll, EPOLL_CTL_ADD, srv.fd_escuta, &ev);
+    ev.data.ptr = &srv.fd_evento;
+    epoll_ctl(srv.fd_epoll, EPOLL_CTL_ADD, srv.fd_evento, &ev);
+
+    int criadas = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, thread_trabalhadora, &srv) != 0) break;
+        criadas++;
+    }
+    pthread_t escritora;
+    int escritora_criada = pthread_create(&escritora, NULL, thread_escritora, &srv) == 0;
+
+    int status = 0;
+    if (criadas == 0 || !escritora_criada) {
+        fprintf(stderr, "Erro ao criar as threads do servidor!\n");
+        status = 1;
+        sinal_encerrar = 1;
+    } else {
+        signal(SIGINT, tratar_sinal);
+        signal(SIGTERM, tratar_sinal);
+        printf("Servidor atendendo em '%s' com %d threads (Ctrl+C para encerrar)\n",
+               endereco, criadas);
+        fflush(stdout);
+    }
+
+    struct epoll_event eventos[SERVIDOR_MAX_EVENTOS];
+    while (!sinal_encerrar) {
+        int n = epoll_wait(srv.fd_epoll, eventos, SERVIDOR_MAX_EVENTOS, 500);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            status = 1;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            void* origem = eventos[i].data.ptr;
+
+            if (origem == &srv.fd_escuta) {
+                aceitar_conexoes(&srv);
+            } else if (origem == &srv.fd_evento) {
+                recolher_lotes(&srv);
+            } else {
+                Conexao* c = (Conexao*)origem;
+                if (c->encerrada) continue;
+
+                if (eventos[i].events & (EPOLLERR | EPOLLHUP)) {
+                    // O cliente não recebe mais nada; um lote pendente é descartado ao voltar
+                    fechar_conexao(&srv, c);
+                    continue;
+                }
+                // A conexão pode ter sido liberada ao fechar; não é mais acessada nesse caso
+                if ((eventos[i].events & EPOLLIN) && !c->fim_entrada) {
+                    if (!ler_conexao(&srv, c)) continue;
+                }
+                if (eventos[i].events & EPOLLOUT) {
+                    atender_conexao(&srv, c);
+                }
+            }
+        }
+    }
+
+    // Encerra o pool e a thread de escrita; os lotes em execução terminam e os demais são
+    // descartados junto com as conexões
+    pthread_mutex_lock(&srv.trava_filas);
+    srv.encerrar = 1;
+    pthread_cond_broadcast(&srv.tem_trabalho);
+    pthread_cond_broadcast(&srv.tem_alteracao);
+    pthread_mutex_unlock(&srv.trava_filas);
+
+    for (int i = 0; i < criadas; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    if (escritora_criada) pthread_join(escritora, NULL);
+
+    liberar_lotes(srv.pendentes_inicio);
+    liberar_lotes(srv.alteracoes_inicio);
+    liberar_lotes(srv.concluidos);
+    while (srv.conexoes) {
+        Conexao* c = srv.conexoes;
+        if (!c->encerrada) close(c->fd);
+        liberar_conexao(&srv, c);
+    }
+
+    printf("Servidor encerrado.\n");
+
+    close(srv.fd_escuta);
+    if (srv.fd_reserva >= 0) close(srv.fd_reserva);
+    close(srv.fd_evento);
+    close(srv.fd_epoll);
+    pthread_rwlock_destroy(&srv.trava_grafo);
+    pthread_mutex_destroy(&srv.trava_filas);
+    pthread_cond_destroy(&srv.tem_trabalho);
+    pthread_cond_destroy(&srv.tem_alteracao);
+    destruir_historico(srv.historico);
+    free(threads);
+
+    return status;
+}
+
+#else
+
+typedef struct Grafo Grafo;
+
+int executar_servidor(Grafo* g, const char* endereco, int num_threads);
+
+// O modo servidor depende de epoll e eventfd, disponíveis apenas no Linux
+int executar_servidor(Grafo* g, const char* endereco, int num_threads) {
+    (void)g;
+    (void)endereco;
+    (void)num_threads;
+    fprintf(stderr, "O modo servidor está disponível apenas no Linux.\n");
+    return 1;
+}
+
+#endif